@@ -85,3 +85,5 @@ void Connection::load(Archive& archive)
 
 template void Connection::save<cereal::JSONOutputArchive>(cereal::JSONOutputArchive& archive) const;
 template void Connection::load<cereal::JSONInputArchive>(cereal::JSONInputArchive& archive);
+template void Connection::save<cereal::PortableBinaryOutputArchive>(cereal::PortableBinaryOutputArchive& archive) const;
+template void Connection::load<cereal::PortableBinaryInputArchive>(cereal::PortableBinaryInputArchive& archive);
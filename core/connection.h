@@ -12,7 +12,7 @@ public:
 	using mutable_connection_t = std::tuple<MutableNodePtr, MutableConnectorMetadataPtr, MutableNodePtr, MutableConnectorMetadataPtr>;
 
 private:
-	struct Impl
+	struct Impl: PoolAllocated
 	{
 		connection_t connection_;
 	};
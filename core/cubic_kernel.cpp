@@ -0,0 +1,197 @@
+#include "cubic_kernel.h"
+
+#include <cassert>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define CUBIC_KERNEL_X86
+	#include <immintrin.h>
+	#ifdef _MSC_VER
+		#include <intrin.h>
+		#define TARGET_SSE2
+		#define TARGET_AVX
+	#else
+		#define TARGET_SSE2 __attribute__((target("sse2")))
+		#define TARGET_AVX __attribute__((target("avx")))
+	#endif
+#endif
+
+using Core::CubicKernel;
+
+using float_kernel_t = void (*)(const float*, const float*, size_t, float*, size_t);
+using double_kernel_t = void (*)(const double*, const float*, size_t, double*, size_t);
+
+template <typename T>
+static void evaluateScalar(const T* a, const float* t, size_t count, T* out, size_t stride) noexcept
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		T x = t[i];
+		out[i * stride] = ((a[0] * x + a[1]) * x + a[2]) * x + a[3];
+	}
+}
+
+#ifdef CUBIC_KERNEL_X86
+
+TARGET_SSE2 static void evaluateSSE2(const float* a, const float* t, size_t count, float* out, size_t stride) noexcept
+{
+	auto a0 = _mm_set1_ps(a[0]), a1 = _mm_set1_ps(a[1]), a2 = _mm_set1_ps(a[2]), a3 = _mm_set1_ps(a[3]);
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		auto x = _mm_loadu_ps(t + i);
+		auto r = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(a0, x), a1), x), a2), x), a3);
+
+		if (stride == 1) _mm_storeu_ps(out + i, r);
+		else
+		{
+			alignas(32) float lanes[4];
+			_mm_store_ps(lanes, r);
+			for (size_t k = 0; k < 4; k++) out[(i + k) * stride] = lanes[k];
+		}
+	}
+	evaluateScalar(a, t + i, count - i, out + i * stride, stride);
+}
+
+TARGET_SSE2 static void evaluateSSE2(const double* a, const float* t, size_t count, double* out, size_t stride) noexcept
+{
+	auto a0 = _mm_set1_pd(a[0]), a1 = _mm_set1_pd(a[1]), a2 = _mm_set1_pd(a[2]), a3 = _mm_set1_pd(a[3]);
+
+	size_t i = 0;
+	for (; i + 2 <= count; i += 2)
+	{
+		auto x = _mm_cvtps_pd(_mm_setr_ps(t[i], t[i + 1], 0, 0));
+		auto r = _mm_add_pd(_mm_mul_pd(_mm_add_pd(_mm_mul_pd(_mm_add_pd(_mm_mul_pd(a0, x), a1), x), a2), x), a3);
+
+		if (stride == 1) _mm_storeu_pd(out + i, r);
+		else
+		{
+			alignas(32) double lanes[2];
+			_mm_store_pd(lanes, r);
+			for (size_t k = 0; k < 2; k++) out[(i + k) * stride] = lanes[k];
+		}
+	}
+	evaluateScalar(a, t + i, count - i, out + i * stride, stride);
+}
+
+TARGET_AVX static void evaluateAVX(const float* a, const float* t, size_t count, float* out, size_t stride) noexcept
+{
+	auto a0 = _mm256_set1_ps(a[0]), a1 = _mm256_set1_ps(a[1]), a2 = _mm256_set1_ps(a[2]), a3 = _mm256_set1_ps(a[3]);
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		auto x = _mm256_loadu_ps(t + i);
+		auto r = _mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(a0, x), a1), x), a2), x), a3);
+
+		if (stride == 1) _mm256_storeu_ps(out + i, r);
+		else
+		{
+			alignas(32) float lanes[8];
+			_mm256_store_ps(lanes, r);
+			for (size_t k = 0; k < 8; k++) out[(i + k) * stride] = lanes[k];
+		}
+	}
+	evaluateScalar(a, t + i, count - i, out + i * stride, stride);
+}
+
+TARGET_AVX static void evaluateAVX(const double* a, const float* t, size_t count, double* out, size_t stride) noexcept
+{
+	auto a0 = _mm256_set1_pd(a[0]), a1 = _mm256_set1_pd(a[1]), a2 = _mm256_set1_pd(a[2]), a3 = _mm256_set1_pd(a[3]);
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		auto x = _mm256_cvtps_pd(_mm_loadu_ps(t + i));
+		auto r = _mm256_add_pd(_mm256_mul_pd(_mm256_add_pd(_mm256_mul_pd(_mm256_add_pd(_mm256_mul_pd(a0, x), a1), x), a2), x), a3);
+
+		if (stride == 1) _mm256_storeu_pd(out + i, r);
+		else
+		{
+			alignas(32) double lanes[4];
+			_mm256_store_pd(lanes, r);
+			for (size_t k = 0; k < 4; k++) out[(i + k) * stride] = lanes[k];
+		}
+	}
+	evaluateScalar(a, t + i, count - i, out + i * stride, stride);
+}
+
+#endif
+
+static bool detect(CubicKernel::InstructionSet instructionSet) noexcept
+{
+	using InstructionSet = CubicKernel::InstructionSet;
+	if (instructionSet == InstructionSet::Scalar) return true;
+
+#if defined(CUBIC_KERNEL_X86) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	if (instructionSet == InstructionSet::SSE2) return (info[3] & (1 << 26)) != 0;
+
+	// AVX also needs the OS to save the ymm registers
+	auto osxsave = (info[2] & (1 << 27)) != 0;
+	auto avx = (info[2] & (1 << 28)) != 0;
+	return osxsave && avx && (_xgetbv(0) & 6) == 6;
+#elif defined(CUBIC_KERNEL_X86)
+	__builtin_cpu_init();
+	if (instructionSet == InstructionSet::SSE2) return __builtin_cpu_supports("sse2");
+	return __builtin_cpu_supports("avx");
+#else
+	return false;
+#endif
+}
+
+struct Kernels
+{
+	CubicKernel::InstructionSet instructionSet;
+	float_kernel_t floats;
+	double_kernel_t doubles;
+};
+
+static Kernels kernelsFor(CubicKernel::InstructionSet instructionSet) noexcept
+{
+	using InstructionSet = CubicKernel::InstructionSet;
+
+#ifdef CUBIC_KERNEL_X86
+	if (instructionSet == InstructionSet::AVX) return { instructionSet, evaluateAVX, evaluateAVX };
+	if (instructionSet == InstructionSet::SSE2) return { instructionSet, evaluateSSE2, evaluateSSE2 };
+#endif
+	return { InstructionSet::Scalar, evaluateScalar<float>, evaluateScalar<double> };
+}
+
+static Kernels& kernels() noexcept
+{
+	using InstructionSet = CubicKernel::InstructionSet;
+
+	static Kernels kernels = kernelsFor(
+		detect(InstructionSet::AVX) ? InstructionSet::AVX :
+		detect(InstructionSet::SSE2) ? InstructionSet::SSE2 :
+		InstructionSet::Scalar);
+	return kernels;
+}
+
+void CubicKernel::evaluate(const float coefficients[4], const float* t, size_t count, float* out, size_t stride) noexcept
+{
+	kernels().floats(coefficients, t, count, out, stride);
+}
+
+void CubicKernel::evaluate(const double coefficients[4], const float* t, size_t count, double* out, size_t stride) noexcept
+{
+	kernels().doubles(coefficients, t, count, out, stride);
+}
+
+bool CubicKernel::supports(InstructionSet instructionSet) noexcept
+{
+	return detect(instructionSet);
+}
+
+CubicKernel::InstructionSet CubicKernel::instructionSet() noexcept
+{
+	return kernels().instructionSet;
+}
+
+void CubicKernel::setInstructionSet(InstructionSet instructionSet) noexcept
+{
+	assert(supports(instructionSet));
+	kernels() = kernelsFor(instructionSet);
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "static.h"
+
+BEGIN_NAMESPACE(Core)
+
+// Evaluates a cubic polynomial a0 * t^3 + a1 * t^2 + a2 * t + a3 for many t at once, using the widest instruction
+// set the CPU supports. Results are written stride values apart, so a single component of an array of vectors can
+// be filled in place.
+class CubicKernel
+{
+public:
+	enum class InstructionSet { Scalar, SSE2, AVX };
+
+	static void evaluate(const float coefficients[4], const float* t, size_t count, float* out, size_t stride = 1) noexcept;
+	static void evaluate(const double coefficients[4], const float* t, size_t count, double* out, size_t stride = 1) noexcept;
+
+	static bool supports(InstructionSet instructionSet) noexcept;
+
+	// Defaults to the widest supported instruction set; meant for comparing the implementations
+	static InstructionSet instructionSet() noexcept;
+	static void setInstructionSet(InstructionSet instructionSet) noexcept;
+};
+
+END_NAMESPACE(Core)
@@ -10,14 +10,119 @@ using Core::Connection;
 using Core::ConnectionPtr;
 using Core::HashValue;
 using Core::ConnectorMetadata;
+using Core::Uuid;
+using Core::tree_t;
 using Core::visibility_t;
+using Core::makePooled;
+using Core::PoolAllocated;
+using Core::Frame;
 using Builder = Document::Builder;
+using JournalEntry = Document::JournalEntry;
+using journal_t = Document::journal_t;
 
-struct Document::Impl
+using visibility_index_t = Core::PersistentIntervalTree<Uuid>;
+
+// The connections that end at and start from a node
+struct NodeEdges
+{
+	Document::connections_t inputs;
+	Document::connections_t outputs;
+};
+
+using adjacency_t = Core::PersistentMap<Uuid, NodeEdges>;
+
+struct Document::Impl: PoolAllocated
 {
+	Impl()
+		: connections_(std::make_shared<const connections_t>())
+	{}
+
+	// Only the node itself counts, not a different version of a node with the same uuid
+	bool contains(const Node& node) const noexcept
+	{
+		auto found = nodes_.find(node.uuid());
+		return found && found->get() == &node;
+	}
+
+	void index(const Node& node) noexcept
+	{
+		visibility_.insert(node.visibility().first, node.visibility().second, node.uuid());
+	}
+
+	void unindex(const Node& node) noexcept
+	{
+		visibility_.erase(node.visibility().first, node.uuid());
+	}
+
+	// Erasing a node erases its whole subtree
+	void unindexSubtree(const Uuid& uuid) noexcept
+	{
+		unindex(**nodes_.find(uuid));
+		for (auto&& child : nodes_.children(uuid)) unindexSubtree(child);
+	}
+
+	void reindex(const Node& before, const Node& after) noexcept
+	{
+		if (before.visibility() == after.visibility()) return;
+		unindex(before);
+		index(after);
+	}
+
+	// Only copies the edges of the two nodes involved
+	void addEdges(const ConnectionPtr& connection) noexcept
+	{
+		auto add = [&](const Uuid& uuid, connections_t NodeEdges::*list)
+		{
+			auto found = adjacency_.find(uuid);
+			auto edges = found ? *found : NodeEdges();
+			(edges.*list).push_back(connection);
+			adjacency_.set(uuid, std::move(edges));
+		};
+
+		add(connection->outputNode()->uuid(), &NodeEdges::outputs);
+		add(connection->inputNode()->uuid(), &NodeEdges::inputs);
+	}
+
+	void removeEdges(const ConnectionPtr& connection) noexcept
+	{
+		auto remove = [&](const Uuid& uuid, connections_t NodeEdges::*list)
+		{
+			auto found = adjacency_.find(uuid);
+			assert(found);
+			auto edges = *found;
+			(edges.*list).erase(std::find(begin(edges.*list), end(edges.*list), connection));
+			if (edges.inputs.empty() && edges.outputs.empty()) adjacency_.erase(uuid);
+			else adjacency_.set(uuid, std::move(edges));
+		};
+
+		remove(connection->outputNode()->uuid(), &NodeEdges::outputs);
+		remove(connection->inputNode()->uuid(), &NodeEdges::inputs);
+	}
+
+	void indexConnections() noexcept
+	{
+		adjacency_ = adjacency_t();
+		for (auto&& connection : *connections_) addEdges(connection);
+	}
+
+	std::vector<NodePtr> resolve(const std::vector<Uuid>& uuids) const noexcept
+	{
+		std::vector<NodePtr> result;
+		result.reserve(uuids.size());
+		for (auto&& uuid : uuids) result.push_back(*nodes_.find(uuid));
+		return result;
+	}
+
+	// Both are shared with every copy of the document until they get mutated
 	tree_t nodes_;
-	connections_t connections_;
+	std::shared_ptr<const connections_t> connections_;
 	Settings settings_;
+
+	// Node visibility, kept up to date by every change to nodes_
+	visibility_index_t visibility_;
+
+	// The edges of every connected node, kept up to date with connections_
+	adjacency_t adjacency_;
 };
 
 Document::Document()
@@ -43,7 +148,7 @@ Document& Document::operator=(Document&& rhs) = default;
 
 const NodePtr& Document::root() const noexcept
 {
-	return *begin(impl_->nodes_);
+	return impl_->nodes_.head();
 }
 
 const Core::tree_t& Document::nodes() const noexcept
@@ -53,7 +158,7 @@ const Core::tree_t& Document::nodes() const noexcept
 
 const Document::connections_t& Document::connections() const noexcept
 {
-	return impl_->connections_;
+	return *impl_->connections_;
 }
 
 const Document::Settings Document::settings() const noexcept
@@ -63,9 +168,11 @@ const Document::Settings Document::settings() const noexcept
 
 NodePtr Document::parent(const Node& node) const noexcept
 {
-	auto it = iteratorFor(this->nodes(), node);
-	auto parent = tree_t::parent(it);
-	if (parent.node == nullptr) return nullptr; // root has no parent
+	assert(impl_->contains(node));
+	if (!impl_->contains(node)) return nullptr;
+
+	auto parent = impl_->nodes_.parent(node.uuid());
+	if (!parent) return nullptr; // root has no parent
 	return *parent;
 }
 
@@ -92,19 +199,24 @@ NodePtr Document::parent(const ConnectorMetadata& connectorMetadata) const noexc
 NodePtr Document::child(const Node& parent, size_t index) const noexcept
 {
 	assert(childCount(parent) > index);
-	auto it = iteratorFor(this->nodes(), parent);
-	return *tree_t::child(it, index);
+	return *impl_->nodes_.find(impl_->nodes_.children(parent.uuid())[index]);
+}
+
+NodePtr Document::find(const Uuid& uuid) const noexcept
+{
+	auto found = impl_->nodes_.find(uuid);
+	return found ? *found : nullptr;
 }
 
 bool Document::exists(const Node& node) const noexcept
 {
-	return std::find_if(cbegin(this->nodes()), cend(this->nodes()), [&](auto& n) { return n.get() == &node; }) != cend(this->nodes());
+	return impl_->contains(node);
 }
 
 size_t Document::childIndex(const Node& node) const noexcept
 {
-	auto it = iteratorFor(this->nodes(), node);
-	return this->nodes().index(it);
+	assert(impl_->contains(node));
+	return impl_->nodes_.index(node.uuid());
 }
 
 size_t Document::childIndex(const Property& prop) const noexcept
@@ -133,34 +245,112 @@ size_t Document::childIndex(const ConnectorMetadata& connectorMetadata) const no
 
 size_t Document::childCount(const Node& node) const noexcept
 {
-	return this->nodes().number_of_children(iteratorFor(this->nodes(), node));
+	return impl_->nodes_.children(node.uuid()).size();
 }
 
 size_t Document::totalChildCount(const Node& node) const noexcept
 {
-	return this->nodes().size(iteratorFor(this->nodes(), node)) - 1; // - 1 because it includes the node itself
+	return impl_->nodes_.subtreeSize(node.uuid()) - 1; // - 1 because it includes the node itself
 }
 
-Document Document::buildRootDocument(NodePtr root) noexcept
+std::vector<NodePtr> Document::activeNodes(Frame frame) const noexcept
 {
-	Document d;
-	d.impl_->nodes_.set_head(root);
+	std::vector<Uuid> uuids;
+	impl_->visibility_.visit(frame, [&](const Uuid& uuid) { uuids.push_back(uuid); });
+	return impl_->resolve(uuids);
+}
+
+std::vector<NodePtr> Document::activeNodes(Frame start, Frame stop) const noexcept
+{
+	std::vector<Uuid> uuids;
+	impl_->visibility_.visit(start, stop, [&](const Uuid& uuid) { uuids.push_back(uuid); });
+	return impl_->resolve(uuids);
+}
+
+const Document::connections_t& Document::inputConnections(const Node& node) const noexcept
+{
+	static const connections_t none;
+	auto edges = impl_->adjacency_.find(node.uuid());
+	return edges ? edges->inputs : none;
+}
+
+const Document::connections_t& Document::outputConnections(const Node& node) const noexcept
+{
+	static const connections_t none;
+	auto edges = impl_->adjacency_.find(node.uuid());
+	return edges ? edges->outputs : none;
+}
+
+Document::Delta Document::deltaFrom(const Document& prev) const noexcept
+{
+	Delta delta;
+	delta.treeBytes = tree_t::diff(prev.impl_->nodes_, impl_->nodes_, [&](const auto& before, const auto& after)
+	{
+		if (after) delta.nodes.emplace_back(after);
+		else delta.erasedNodes.emplace_back(before->key);
+	});
+
+	if (impl_->connections_ != prev.impl_->connections_) delta.connections = impl_->connections_;
+	delta.settings = impl_->settings_;
+	return delta;
+}
+
+Document Document::apply(const Delta& delta) const noexcept
+{
+	Document d(*this);
+	for (auto&& uuid : delta.erasedNodes)
+	{
+		d.impl_->unindex(**d.impl_->nodes_.find(uuid));
+		d.impl_->nodes_.removeEntry(uuid);
+	}
+	for (auto&& entry : delta.nodes)
+	{
+		auto before = d.impl_->nodes_.find(entry->key);
+		if (before) d.impl_->reindex(**before, *entry->value);
+		else d.impl_->index(*entry->value);
+		d.impl_->nodes_.setEntry(entry);
+	}
+	if (delta.connections)
+	{
+		d.impl_->connections_ = delta.connections;
+		d.impl_->indexConnections();
+	}
+	d.impl_->settings_ = delta.settings;
 	return d;
 }
 
-Core::tree_t::iterator Document::iteratorFor(const Core::tree_t& tree, const Node& node) noexcept
+size_t Document::Delta::bytes() const noexcept
 {
-	auto it = std::find_if(cbegin(tree), cend(tree), [&node](auto& n) { return n.get() == &node; });
-	assert(it != end(tree));
-	return it;
+	auto result = sizeof(Delta);
+	result += nodes.capacity() * sizeof(tree_t::EntryPtr) + erasedNodes.capacity() * sizeof(Uuid);
+
+	for (auto&& entry : nodes)
+	{
+		result += sizeof(tree_t::Entry) + sizeof(Node) + entry->value->properties().size() * sizeof(Property);
+		if (!entry->children.empty()) result += entry->children.pathBytes();
+	}
+
+	if (connections) result += connections->capacity() * (sizeof(ConnectionPtr) + sizeof(Connection));
+	return result;
 }
 
-#ifdef _DEBUG
-#include <tree/tree_util.h>
+Document Document::buildRootDocument(NodePtr root) noexcept
+{
+	Document d;
+	d.impl_->nodes_.setHead(root->uuid(), root);
+	d.impl_->index(*root);
+	return d;
+}
 
+#ifdef _DEBUG
 void Document::dumpTree() const
 {
-	print_tree_bracketed(impl_->nodes_);
+	std::function<void(const Uuid&, size_t)> dump = [&](const Uuid& uuid, size_t depth)
+	{
+		std::cout << std::string(depth * 2, ' ') << uuid << std::endl;
+		for (auto& child : impl_->nodes_.children(uuid)) dump(child, depth + 1);
+	};
+	dump(root()->uuid(), 0);
 }
 #endif
 
@@ -168,9 +358,58 @@ void Document::dumpTree() const
 // Builder boilerplate
 /////////////////////////////////////////////////////////
 
-struct Builder::BuilderImpl
+struct Builder::BuilderImpl: PoolAllocated
 {
-	std::map<NodePtr, NodePtr> mutatedNodes_;
+	BuilderImpl() = default;
+
+	// Copies make their own copy of the connections once they change them
+	BuilderImpl(const BuilderImpl& rhs)
+		: journal_(rhs.journal_)
+		, fixedUpTo_(rhs.fixedUpTo_)
+	{}
+
+	BuilderImpl& operator=(const BuilderImpl& rhs)
+	{
+		journal_ = rhs.journal_;
+		fixedUpTo_ = rhs.fixedUpTo_;
+		connections_.reset();
+		return *this;
+	}
+
+	journal_t journal_;
+
+	// Journal entries up to here have had their connections fixed up
+	size_t fixedUpTo_ {};
+
+	// The connections of the document are copied once, on the first change, and then changed in place
+	std::shared_ptr<connections_t> connections_;
+
+	connections_t& ownConnections(Impl& impl)
+	{
+		if (!connections_)
+		{
+			connections_ = std::make_shared<connections_t>(*impl.connections_);
+			impl.connections_ = connections_;
+		}
+		return *connections_;
+	}
+
+	void record(JournalEntry::Type type, const Uuid& node, HashValue property = HashValue())
+	{
+		journal_.push_back({ type, node, property, nullptr });
+	}
+
+	void record(JournalEntry::Type type, const ConnectionPtr& connection)
+	{
+		journal_.push_back({ type, Uuid(), HashValue(), connection });
+	}
+
+	// Erasing a node erases its whole subtree
+	void recordRemoved(const tree_t& nodes, const Uuid& node)
+	{
+		record(JournalEntry::Type::NodeRemoved, node);
+		for (auto&& child : nodes.children(node)) recordRemoved(nodes, child);
+	}
 };
 
 Builder::Builder(const Document& d)
@@ -184,12 +423,16 @@ Builder::~Builder() = default;
 Builder::Builder(const Builder& rhs)
 	: impl_(std::make_unique<Impl>(*rhs.impl_))
 	, builderImpl_(std::make_unique<BuilderImpl>(*rhs.builderImpl_))
-{}
+{
+	// rhs changes its connections in place, so a copy can't share them
+	if (rhs.builderImpl_->connections_) builderImpl_->ownConnections(*impl_);
+}
 
 Builder& Builder::operator=(const Builder& rhs)
 {
 	*impl_ = *rhs.impl_;
 	*builderImpl_ = *rhs.builderImpl_;
+	if (rhs.builderImpl_->connections_) builderImpl_->ownConnections(*impl_);
 	return *this;
 }
 
@@ -212,13 +455,19 @@ void Builder::mutate(NodePtr node, mutate_fn fn) const noexcept
 	fn(b);
 
 	// Construct the new node
-	auto&& newNode = std::make_shared<Node>(std::move(b));
-	builderImpl_->mutatedNodes_[node] = newNode;
+	auto&& newNode = makePooled<Node>(std::move(b));
+
+	builderImpl_->record(JournalEntry::Type::NodeMutated, node->uuid());
+	for (auto&& prop : newNode->properties())
+	{
+		auto prevProp = find_if(cbegin(node->properties()), cend(node->properties()), property_eq_hash(prop));
+		if (prevProp == cend(node->properties()) || *prevProp != prop) builderImpl_->record(JournalEntry::Type::PropertyMutated, node->uuid(), prop->propertyType());
+	}
 
-	// Replace it in the tree
-	auto pos = find(begin(impl_->nodes_), end(impl_->nodes_), node);
-	assert(pos != end(impl_->nodes_));
-	impl_->nodes_.replace(pos, newNode);
+	// Replace it in the tree, this only copies the path to the node
+	assert(impl_->contains(*node));
+	impl_->nodes_.replace(node->uuid(), newNode);
+	impl_->reindex(*node, *newNode);
 }
 
 void Builder::mutateSettings(const Document::Settings newSettings) noexcept
@@ -228,10 +477,25 @@ void Builder::mutateSettings(const Document::Settings newSettings) noexcept
 
 void Builder::fixupConnections() const
 {
-	connections_t fixed;
+	auto& journal = builderImpl_->journal_;
 
-	// Replace it in the connections
-	for (auto& conPtr: impl_->connections_)
+	// Only the connections of nodes that changed since the last fixup can need fixing
+	std::vector<ConnectionPtr> affected;
+	std::unordered_set<const Connection*> seen;
+	for (auto i = builderImpl_->fixedUpTo_; i < journal.size(); i++)
+	{
+		auto type = journal[i].type;
+		if (type != JournalEntry::Type::NodeMutated && type != JournalEntry::Type::NodeRemoved) continue;
+
+		auto edges = impl_->adjacency_.find(journal[i].node);
+		if (!edges) continue;
+		for (auto&& connection : edges->inputs) if (seen.insert(connection.get()).second) affected.push_back(connection);
+		for (auto&& connection : edges->outputs) if (seen.insert(connection.get()).second) affected.push_back(connection);
+	}
+
+	// The fixed version of every affected connection, or nullptr if it has to go
+	std::unordered_map<const Connection*, ConnectionPtr> fixed;
+	for (auto&& conPtr : affected)
 	{
 		NodePtr outputNode;
 		ConnectorMetadataPtr output;
@@ -239,41 +503,60 @@ void Builder::fixupConnections() const
 		ConnectorMetadataPtr input;
 		tie(outputNode, output, inputNode, input) = conPtr->connection();
 
-		// Has the output or input node mutated?
-		auto hasMutated = builderImpl_->mutatedNodes_.find(outputNode);
-		if (hasMutated != end(builderImpl_->mutatedNodes_)) outputNode = hasMutated->second;
-
-		hasMutated = builderImpl_->mutatedNodes_.find(inputNode);
-		if (hasMutated != end(builderImpl_->mutatedNodes_)) inputNode = hasMutated->second;
-
 		// Has the output or input node been deleted?
-		if (find(begin(impl_->nodes_), end(impl_->nodes_), outputNode) == end(impl_->nodes_)) continue;
-		if (find(begin(impl_->nodes_), end(impl_->nodes_), inputNode) == end(impl_->nodes_)) continue;
-
-		auto con = make_tuple(outputNode, output, inputNode, input);
-		if (con != conPtr->connection())
+		auto currentOutput = impl_->nodes_.find(outputNode->uuid());
+		auto currentInput = impl_->nodes_.find(inputNode->uuid());
+		if (!currentOutput || !currentInput)
 		{
-			fixed.emplace_back(std::make_shared<const Connection>(con));
+			fixed[conPtr.get()] = nullptr;
+			builderImpl_->record(JournalEntry::Type::ConnectionRemoved, conPtr);
+			continue;
 		}
-		else
+
+		// Has the output or input node mutated?
+		auto con = make_tuple(*currentOutput, output, *currentInput, input);
+		if (con != conPtr->connection())
 		{
-			fixed.emplace_back(conPtr);
+			auto& replacement = fixed[conPtr.get()] = makePooled<const Connection>(con);
+			builderImpl_->record(JournalEntry::Type::ConnectionRemoved, conPtr);
+			builderImpl_->record(JournalEntry::Type::ConnectionAdded, replacement);
 		}
 	}
 
-	impl_->connections_ = fixed;
+	builderImpl_->fixedUpTo_ = journal.size();
+	if (fixed.empty()) return;
+
+	for (auto&& connection : affected)
+	{
+		auto it = fixed.find(connection.get());
+		if (it == end(fixed)) continue;
+		impl_->removeEdges(connection);
+		if (it->second) impl_->addEdges(it->second);
+	}
+
+	// Keep the order of the connections, replacing the fixed ones where they are
+	auto& connections = builderImpl_->ownConnections(*impl_);
+	size_t kept = 0;
+	for (size_t i = 0; i < connections.size(); i++)
+	{
+		auto it = fixed.find(connections[i].get());
+		if (it == end(fixed)) std::swap(connections[kept++], connections[i]);
+		else if (it->second) connections[kept++] = it->second;
+	}
+	connections.resize(kept);
 }
 
 void Builder::insertBefore(NodePtr before, std::initializer_list<NodePtr> nodes) noexcept
 {
 	assert(before);
-	auto beforePos = iteratorFor(impl_->nodes_, *before);
+	auto beforeUuid = before->uuid();
 
 	for (auto&& node : nodes)
 	{
-		impl_->nodes_.insert(beforePos, node);
-		auto nodePos = iteratorFor(impl_->nodes_, *node);
-		beforePos = nodePos;
+		impl_->nodes_.insertBefore(beforeUuid, node->uuid(), node);
+		impl_->index(*node);
+		builderImpl_->record(JournalEntry::Type::NodeAdded, node->uuid());
+		beforeUuid = node->uuid();
 	}
 }
 
@@ -285,24 +568,26 @@ void Builder::append(std::initializer_list<NodePtr> nodes) noexcept
 void Builder::append(NodePtr parent, std::initializer_list<NodePtr> nodes) noexcept
 {
 	assert(parent);
-	auto parentPos = iteratorFor(impl_->nodes_, *parent);
+	assert(impl_->contains(*parent));
 
 	for (auto&& node : nodes)
 	{
-		impl_->nodes_.append_child(parentPos, node);
+		impl_->nodes_.appendChild(parent->uuid(), node->uuid(), node);
+		impl_->index(*node);
+		builderImpl_->record(JournalEntry::Type::NodeAdded, node->uuid());
 	}
 }
 
 void Builder::moveAfter(NodePtr after, std::initializer_list<NodePtr> nodes) noexcept
 {
 	assert(after);
-	auto afterPos = iteratorFor(impl_->nodes_, *after);
+	auto afterUuid = after->uuid();
 
 	for (auto&& node : nodes)
 	{
-		auto nodePos = iteratorFor(impl_->nodes_, *node);
-		impl_->nodes_.move_after(afterPos, nodePos);
-		afterPos = nodePos;
+		builderImpl_->record(JournalEntry::Type::NodeMoved, node->uuid());
+		impl_->nodes_.moveAfter(afterUuid, node->uuid());
+		afterUuid = node->uuid();
 	}
 }
 
@@ -310,12 +595,12 @@ void Builder::erase(std::vector<NodePtr> nodes) noexcept
 {
 	for (auto&& node : nodes)
 	{
-		auto pos = find(begin(impl_->nodes_), end(impl_->nodes_), node);
-
 		// May already have been deleted because parent was deleted
-		if (pos != end(impl_->nodes_))
+		if (impl_->contains(*node))
 		{
-			impl_->nodes_.erase(pos);
+			builderImpl_->recordRemoved(impl_->nodes_, node->uuid());
+			impl_->unindexSubtree(node->uuid());
+			impl_->nodes_.erase(node->uuid());
 		}
 	}
 }
@@ -329,26 +614,41 @@ void Builder::erase(std::initializer_list<NodePtr> nodes) noexcept
 
 void Builder::eraseChildren(std::initializer_list<NodePtr> nodes) noexcept
 {
-	for (auto&& node : nodes) impl_->nodes_.erase_children(find(begin(impl_->nodes_), end(impl_->nodes_), node));
+	for (auto&& node : nodes)
+	{
+		for (auto&& child : impl_->nodes_.children(node->uuid()))
+		{
+			builderImpl_->recordRemoved(impl_->nodes_, child);
+			impl_->unindexSubtree(child);
+		}
+		impl_->nodes_.eraseChildren(node->uuid());
+	}
 }
 
 void Builder::reparent(NodePtr parent, std::initializer_list<NodePtr> nodes) noexcept
 {
-	auto parentPos = iteratorFor(impl_->nodes_, *parent);
+	assert(impl_->contains(*parent));
 
 	for (auto&& node: nodes)
 	{
-		auto it = iteratorFor(impl_->nodes_, *node);
-		impl_->nodes_.reparent(parentPos, it, impl_->nodes_.next_sibling(it));
+		builderImpl_->record(JournalEntry::Type::NodeMoved, node->uuid());
+		impl_->nodes_.reparent(parent->uuid(), node->uuid());
 
 		// Sanity check
-		assert((*tree_t::parent(it)).get() == parent.get());
+		assert(impl_->nodes_.parent(node->uuid())->get() == parent.get());
 	}
 }
 
 void Builder::connect(ConnectionPtr connection)
 {
-	impl_->connections_.emplace_back(connection);
+	builderImpl_->ownConnections(*impl_).emplace_back(connection);
+	impl_->addEdges(connection);
+	builderImpl_->record(JournalEntry::Type::ConnectionAdded, connection);
+}
+
+const Document::journal_t& Builder::journal() const noexcept
+{
+	return builderImpl_->journal_;
 }
 
 ///
@@ -362,9 +662,10 @@ void Document::save(Archive& archive) const
 	archive(*it++);
 
 	std::vector<std::pair<NodePtr, NodePtr>> nodes;
-	std::for_each(it, end(impl_->nodes_), [&](auto& node) { nodes.emplace_back(std::make_pair(this->parent(*node), node)); });
+	nodes.reserve(impl_->nodes_.size());
+	for (; it != end(impl_->nodes_); ++it) nodes.emplace_back(std::make_pair(*impl_->nodes_.find(it.entry().parent), *it));
 	archive(nodes);
-	archive(impl_->connections_);
+	archive(*impl_->connections_);
 }
 
 template<class Archive>
@@ -372,27 +673,51 @@ void Document::load(Archive& archive)
 {
 	MutableNodePtr root;
 	archive(root);
-	impl_->nodes_.set_head(root);
 
 	std::vector<std::pair<MutableNodePtr, MutableNodePtr>> nodes;
 	archive(nodes);
 
+	// Collect the children of every node first, so each entry is stored once with its final child list and label
+	std::unordered_map<Uuid, std::vector<Uuid>> children;
+	std::vector<size_t> indices;
+	children.reserve(nodes.size());
+	indices.reserve(nodes.size());
 	for (auto&& kvp : nodes)
 	{
-		auto&& parent = kvp.first;
-		auto&& child = kvp.second;
-		impl_->nodes_.insert(end(impl_->nodes_), child);
+		auto& c = children[kvp.first->uuid()];
+		indices.push_back(c.size());
+		c.push_back(kvp.second->uuid());
+	}
+
+	auto childrenOf = [&](const Uuid& uuid)
+	{
+		auto it = children.find(uuid);
+		return it != end(children) ? tree_t::children_t(it->second) : tree_t::children_t();
+	};
 
-		auto parentPos = iteratorFor(impl_->nodes_, *parent);
-		auto it = iteratorFor(impl_->nodes_, *child);
-		impl_->nodes_.reparent(parentPos, it, impl_->nodes_.next_sibling(it));
+	impl_->nodes_.setEntry(makePooled<tree_t::Entry>(tree_t::Entry { root->uuid(), root, Uuid(), false, childrenOf(root->uuid()) }));
+	for (size_t i = 0; i < nodes.size(); i++)
+	{
+		auto&& parent = nodes[i].first;
+		auto&& child = nodes[i].second;
+		auto label = tree_t::children_t::spacedLabel(indices[i]);
+		impl_->nodes_.setEntry(makePooled<tree_t::Entry>(tree_t::Entry { child->uuid(), child, parent->uuid(), true, childrenOf(child->uuid()), label }));
 	}
 
+	std::vector<visibility_index_t::Interval> intervals;
+	intervals.reserve(nodes.size() + 1);
+	intervals.push_back({ root->visibility().first, root->visibility().second, root->uuid() });
+	for (auto&& kvp : nodes) intervals.push_back({ kvp.second->visibility().first, kvp.second->visibility().second, kvp.second->uuid() });
+	impl_->visibility_ = visibility_index_t(std::move(intervals));
+
 	std::vector<MutableConnectionPtr> connections;
 	archive(connections);
-	for (auto&& con : connections) impl_->connections_.emplace_back(con);
+	impl_->connections_ = std::make_shared<const connections_t>(cbegin(connections), cend(connections));
+	impl_->indexConnections();
 }
 
 template void Document::save<cereal::JSONOutputArchive>(cereal::JSONOutputArchive& archive) const;
 template void Document::load<cereal::JSONInputArchive>(cereal::JSONInputArchive& archive);
+template void Document::save<cereal::PortableBinaryOutputArchive>(cereal::PortableBinaryOutputArchive& archive) const;
+template void Document::load<cereal::PortableBinaryInputArchive>(cereal::PortableBinaryInputArchive& archive);
 
@@ -1,6 +1,7 @@
 #pragma once
 #include "static.h"
 #include "node.h"
+#include "interval_tree.h"
 
 BEGIN_NAMESPACE(Core)
 
@@ -14,6 +15,31 @@ public:
 		visibility_t visibility;
 	};
 
+	// Everything that changed between two versions of a document. Applying it to the older version gives the newer one.
+	struct Delta
+	{
+		std::vector<tree_t::EntryPtr> nodes;
+		std::vector<Uuid> erasedNodes;
+		std::shared_ptr<const connections_t> connections; // only set when the connections changed
+		Settings settings;
+		size_t treeBytes {}; // trie branches a full copy of the newer version holds on to, on top of the older version
+
+		size_t bytes() const noexcept;
+	};
+
+	// A single change made by a Builder. Property entries also set property, connection entries only set connection.
+	struct JournalEntry
+	{
+		enum class Type { NodeAdded, NodeRemoved, NodeMoved, NodeMutated, PropertyMutated, ConnectionAdded, ConnectionRemoved };
+
+		Type type;
+		Uuid node;
+		HashValue property;
+		ConnectionPtr connection;
+	};
+
+	using journal_t = std::vector<JournalEntry>;
+
 private:
 	struct Impl;
 
@@ -30,12 +56,17 @@ public:
 	const NodePtr& root() const noexcept;
 	const tree_t& nodes() const noexcept;
 	const connections_t& connections() const noexcept;
+
+	// The connections that end at or start from node, without going through all connections
+	const connections_t& inputConnections(const Node& node) const noexcept;
+	const connections_t& outputConnections(const Node& node) const noexcept;
 	const Settings settings() const noexcept;
 
 	NodePtr parent(const Node& node) const noexcept;
 	NodePtr parent(const Property& prop) const noexcept;
 	NodePtr parent(const ConnectorMetadata& connectorMetadata) const noexcept;
 	NodePtr child(const Node& parent, size_t index) const noexcept;
+	NodePtr find(const Uuid& uuid) const noexcept;
 	bool exists(const Node& node) const noexcept;
 	size_t childIndex(const Node& node) const noexcept;
 	size_t childIndex(const Property& prop) const noexcept;
@@ -43,6 +74,13 @@ public:
 	size_t childCount(const Node& node) const noexcept;
 	size_t totalChildCount(const Node& node) const noexcept;
 
+	// Nodes whose visibility contains frame, or overlaps [start, stop], ordered by the frame they become visible
+	std::vector<NodePtr> activeNodes(Frame frame) const noexcept;
+	std::vector<NodePtr> activeNodes(Frame start, Frame stop) const noexcept;
+
+	Delta deltaFrom(const Document& prev) const noexcept;
+	Document apply(const Delta& delta) const noexcept;
+
 	class Builder
 	{
 		struct BuilderImpl;
@@ -76,6 +114,9 @@ public:
 
 		void fixupConnections() const;
 
+		// Everything this builder changed, in order
+		const journal_t& journal() const noexcept;
+
 	private:
 		Builder() = default;
 		friend class Document;
@@ -98,7 +139,6 @@ private:
 	template<class Archive> void save(Archive& archive) const;
 	template<class Archive>	void load(Archive& archive);
 
-	static tree_t::iterator iteratorFor(const tree_t& tree, const Node& node) noexcept;
 	std::unique_ptr<Impl> impl_;
 };
 
@@ -0,0 +1,40 @@
+#include "evaluation_cache.h"
+#include "connection.h"
+
+using Core::MutationInfo;
+using Core::NodePtr;
+using Core::Uuid;
+
+std::vector<NodePtr> Core::findDirtyNodes(const MutationInfo& info)
+{
+	std::vector<NodePtr> pending;
+	auto add = [&](const NodePtr& node) { if (node) pending.push_back(node); };
+
+	for (auto&& change : info.properties) add(change.curParent);
+	for (auto&& change : info.nodes)
+	{
+		if (change.type == MutationInfo::ChangeType::Mutated) add(change.cur);
+	}
+
+	// Removed connections still point at the nodes as they were, so look those up again
+	for (auto&& change : info.connections)
+	{
+		auto& connection = change.cur ? change.cur : change.prev;
+		add(info.cur.find(connection->inputNode()->uuid()));
+	}
+
+	// Everything downstream depends on the changed nodes through its inputs
+	std::unordered_set<Uuid> seen;
+	std::vector<NodePtr> dirty;
+	while (!pending.empty())
+	{
+		auto node = std::move(pending.back());
+		pending.pop_back();
+		if (!seen.insert(node->uuid()).second) continue;
+
+		for (auto&& connection : info.cur.outputConnections(*node)) add(connection->inputNode());
+		dirty.push_back(std::move(node));
+	}
+
+	return dirty;
+}
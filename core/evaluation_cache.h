@@ -0,0 +1,103 @@
+#pragma once
+#include "static.h"
+#include "mutation_info.h"
+
+#include <atomic>
+#include <mutex>
+
+BEGIN_NAMESPACE(Core)
+
+// The nodes whose results may be stale after a mutation: the nodes it changed a property of, the nodes whose
+// connections changed or that were mutated otherwise, and every node downstream of those. The nodes are taken from the
+// current document, each one once.
+std::vector<NodePtr> findDirtyNodes(const MutationInfo& info);
+
+// Results of evaluating nodes, per node and frame. Nodes are immutable, so a mutated node has a new pointer and never
+// finds the results of its old version; invalidate() drops those old results, and the results of nodes downstream of
+// a change, whose pointers stay the same. Safe to use from several threads; results are computed outside the lock.
+template <typename T>
+class EvaluationCache
+{
+public:
+	using compute_fn = std::function<T(const NodePtr& node, Frame frame)>;
+
+	// The result of node at frame, computed with fn if it is not cached yet
+	T get(const NodePtr& node, Frame frame, const compute_fn& fn)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			auto entry = entries_.find(node.get());
+			if (entry != end(entries_))
+			{
+				auto result = entry->second.results.find(frame);
+				if (result != end(entry->second.results))
+				{
+					hits_++;
+					return result->second;
+				}
+			}
+		}
+
+		misses_++;
+		auto result = fn(node, frame);
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		auto& entry = entries_[node.get()];
+		entry.node = node;
+		entry.results.emplace(frame, result);
+		return result;
+	}
+
+	bool contains(const Node& node, Frame frame) const
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		auto entry = entries_.find(&node);
+		return entry != end(entries_) && entry->second.results.count(frame);
+	}
+
+	// Drops every result a mutation may have made stale, and returns how many nodes lost their results
+	size_t invalidate(const MutationInfo& info)
+	{
+		auto dirty = findDirtyNodes(info);
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		size_t dropped = 0;
+		for (auto&& node : dirty) dropped += entries_.erase(node.get());
+		for (auto&& change : info.nodes)
+		{
+			if (change.prev) dropped += entries_.erase(change.prev.get());
+		}
+		return dropped;
+	}
+
+	void clear()
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		entries_.clear();
+	}
+
+	// Number of nodes that have results
+	size_t size() const
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		return entries_.size();
+	}
+
+	size_t hits() const noexcept { return hits_; }
+	size_t misses() const noexcept { return misses_; }
+	void resetCounters() noexcept { hits_ = 0; misses_ = 0; }
+
+private:
+	struct Entry
+	{
+		NodePtr node; // keeps the node alive, so its address can not be reused by another node
+		std::unordered_map<Frame, T> results;
+	};
+
+	mutable std::mutex mutex_;
+	std::unordered_map<const Node*, Entry> entries_;
+	std::atomic<size_t> hits_ { 0 };
+	std::atomic<size_t> misses_ { 0 };
+};
+
+END_NAMESPACE(Core)
@@ -0,0 +1,110 @@
+#include "graph_scheduler.h"
+#include "connection.h"
+
+using Core::Document;
+using Core::GraphScheduler;
+using Core::Node;
+using Core::ThreadPool;
+
+GraphScheduler::GraphScheduler(const Document& document)
+{
+	auto& nodes = document.nodes();
+	nodes_.reserve(nodes.size());
+	indices_.reserve(nodes.size());
+	for (auto&& node : nodes)
+	{
+		indices_[node.get()] = nodes_.size();
+		nodes_.push_back(node);
+	}
+
+	// Flatten the connections into one list of target nodes per node, so sorting below needs no more lookups
+	std::vector<size_t> targetOffsets;
+	std::vector<size_t> targets;
+	std::vector<size_t> pending(nodes_.size());
+	targetOffsets.reserve(nodes_.size() + 1);
+	targetOffsets.push_back(0);
+
+	for (auto&& node : nodes_)
+	{
+		for (auto&& connection : document.outputConnections(*node))
+		{
+			auto it = indices_.find(connection->inputNode().get());
+			assert(it != end(indices_));
+			targets.push_back(it->second);
+			pending[it->second]++;
+		}
+		targetOffsets.push_back(targets.size());
+	}
+
+	// Kahn's algorithm, one wave at a time: a node is ready once all connections into it have been seen
+	std::vector<size_t> ready;
+	for (size_t i = 0; i < nodes_.size(); i++)
+	{
+		if (!pending[i]) ready.push_back(i);
+	}
+
+	size_t scheduled = 0;
+	while (!ready.empty())
+	{
+		std::vector<size_t> next;
+		for (auto i : ready)
+		{
+			for (auto t = targetOffsets[i]; t < targetOffsets[i + 1]; t++)
+			{
+				if (!--pending[targets[t]]) next.push_back(targets[t]);
+			}
+		}
+
+		// Keep every wave in document order, so the schedule does not depend on the order connections were made in
+		std::sort(begin(next), end(next));
+
+		scheduled += ready.size();
+		waveIndices_.push_back(std::move(ready));
+		ready = std::move(next);
+	}
+
+	// Whatever is still waiting for an input can never become ready
+	if (scheduled < nodes_.size())
+	{
+		for (size_t i = 0; i < nodes_.size(); i++)
+		{
+			if (pending[i]) cyclicNodes_.push_back(nodes_[i]);
+		}
+	}
+
+	for (auto&& indices : waveIndices_)
+	{
+		wave_t wave;
+		wave.reserve(indices.size());
+		for (auto i : indices) wave.push_back(nodes_[i]);
+		waves_.push_back(std::move(wave));
+	}
+
+	durations_.resize(nodes_.size());
+}
+
+void GraphScheduler::run(ThreadPool& pool, const node_fn& fn)
+{
+	std::fill(begin(durations_), end(durations_), duration_t::zero());
+
+	for (auto&& indices : waveIndices_)
+	{
+		// Node evaluation is coarse enough to schedule every node on its own
+		pool.parallelFor(indices.size(), 1, [&](size_t begin, size_t end)
+		{
+			for (auto i = begin; i < end; i++)
+			{
+				auto index = indices[i];
+				auto started = std::chrono::steady_clock::now();
+				fn(nodes_[index]);
+				durations_[index] = std::chrono::duration_cast<duration_t>(std::chrono::steady_clock::now() - started);
+			}
+		});
+	}
+}
+
+GraphScheduler::duration_t GraphScheduler::duration(const Node& node) const noexcept
+{
+	auto it = indices_.find(&node);
+	return it != end(indices_) ? durations_[it->second] : duration_t::zero();
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "static.h"
+#include "document.h"
+#include "thread_pool.h"
+
+#include <chrono>
+
+BEGIN_NAMESPACE(Core)
+
+// Orders the nodes of a document along their connections, so every node comes after the nodes connected to its
+// inputs. Nodes are grouped into waves: a node is in the wave after the last of the nodes it depends on, so the nodes
+// within one wave never depend on each other and can run at the same time.
+class GraphScheduler
+{
+public:
+	using wave_t = std::vector<NodePtr>;
+	using node_fn = std::function<void(const NodePtr&)>;
+	using duration_t = std::chrono::nanoseconds;
+
+	explicit GraphScheduler(const Document& document);
+
+	const std::vector<wave_t>& waves() const noexcept { return waves_; }
+
+	// Nodes on a cycle, or depending on one, in document order. These are left out of the waves.
+	const std::vector<NodePtr>& cyclicNodes() const noexcept { return cyclicNodes_; }
+	bool hasCycle() const noexcept { return !cyclicNodes_.empty(); }
+
+	// Calls fn for every node in the waves, one wave after the other, and spreads the nodes of a wave over the pool
+	void run(ThreadPool& pool, const node_fn& fn);
+
+	// How long fn took for node during the last run, or zero if it was not run
+	duration_t duration(const Node& node) const noexcept;
+
+private:
+	std::vector<NodePtr> nodes_;
+	std::unordered_map<const Node*, size_t> indices_;
+	std::vector<std::vector<size_t>> waveIndices_;
+	std::vector<wave_t> waves_;
+	std::vector<NodePtr> cyclicNodes_;
+	std::vector<duration_t> durations_;
+};
+
+END_NAMESPACE(Core)
@@ -0,0 +1,57 @@
+#pragma once
+#include "static.h"
+
+#include <mutex>
+
+BEGIN_NAMESPACE(Core)
+
+// Deduplicates immutable objects: interning a value returns an equal instance that is already in use, if there is
+// one, so identical objects share storage. The table only holds weak references, which are swept whenever the table
+// has doubled in size since the last sweep.
+template <typename T, typename Hash = std::hash<T>, typename Equal = std::equal_to<T>>
+class InternTable
+{
+public:
+	using pointer_t = std::shared_ptr<const T>;
+
+	pointer_t intern(pointer_t value)
+	{
+		auto hash = Hash()(*value);
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		auto range = entries_.equal_range(hash);
+		for (auto it = range.first; it != range.second; ++it)
+		{
+			auto existing = it->second.lock();
+			if (existing && Equal()(*existing, *value)) return existing;
+		}
+
+		entries_.emplace(hash, value);
+		if (entries_.size() >= sweepAt_) sweep();
+		return value;
+	}
+
+	// Number of distinct instances in use
+	size_t size() const
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		return std::count_if(begin(entries_), end(entries_), [](auto& entry) { return !entry.second.expired(); });
+	}
+
+private:
+	void sweep()
+	{
+		for (auto it = begin(entries_); it != end(entries_);)
+		{
+			if (it->second.expired()) it = entries_.erase(it);
+			else ++it;
+		}
+		sweepAt_ = std::max<size_t>(64, entries_.size() * 2);
+	}
+
+	mutable std::mutex mutex_;
+	std::unordered_multimap<size_t, std::weak_ptr<const T>> entries_;
+	size_t sweepAt_ = 64;
+};
+
+END_NAMESPACE(Core)
@@ -0,0 +1,213 @@
+#pragma once
+#include "static.h"
+#include "pool.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+BEGIN_NAMESPACE(Core)
+
+// An immutable set of frame intervals with a value each, stored as a treap ordered on (start, value) where every
+// node also knows the largest stop frame below it. Copying is O(1), and inserting or erasing an interval only copies
+// the O(log N) nodes on its path, so every document version can keep its own index without duplicating the rest.
+// Intervals are half open: an interval is active at frame F if start <= F < stop.
+template <typename T, typename Hash = std::hash<T>>
+class PersistentIntervalTree
+{
+public:
+	struct Interval
+	{
+		Frame start;
+		Frame stop;
+		T value;
+	};
+
+	PersistentIntervalTree() = default;
+
+	// Builds the tree in one go, which is O(N log N) for the sort and O(N) for the tree itself
+	explicit PersistentIntervalTree(std::vector<Interval> intervals)
+	{
+		std::sort(begin(intervals), end(intervals), [](const Interval& a, const Interval& b) { return less(a.start, a.value, b.start, b.value); });
+
+		// Cartesian tree construction: the stack holds the right spine of the tree built so far. Nodes that get popped
+		// off it are complete, so that is when their maximum stop frame is known.
+		std::vector<MutableNodePtr> spine;
+		for (auto&& interval : intervals)
+		{
+			auto node = makePooled<Node>(interval);
+			MutableNodePtr last;
+			while (!spine.empty() && spine.back()->priority < node->priority)
+			{
+				last = spine.back();
+				spine.pop_back();
+				update(*last);
+			}
+
+			node->left = last;
+			if (!spine.empty()) spine.back()->right = node;
+			spine.push_back(node);
+		}
+
+		for (auto it = spine.rbegin(); it != spine.rend(); ++it) update(**it);
+		if (!spine.empty()) root_ = spine.front();
+
+		size_ = intervals.size();
+	}
+
+	size_t size() const noexcept { return size_; }
+	bool empty() const noexcept { return size_ == 0; }
+
+	void insert(Frame start, Frame stop, const T& value) noexcept
+	{
+		root_ = insert(root_, makePooled<Node>(Interval { start, stop, value }));
+		size_++;
+	}
+
+	// The interval is found by its start frame and value, so start has to be the frame it was inserted with
+	void erase(Frame start, const T& value) noexcept
+	{
+		auto before = size_;
+		root_ = erase(root_, start, value);
+		assert(size_ == before - 1);
+		(void)before;
+	}
+
+	// Calls fn with the value of every interval active at frame, in order of start frame
+	template <typename Fn>
+	void visit(Frame frame, Fn&& fn) const
+	{
+		visit(root_, frame, frame, fn);
+	}
+
+	// Calls fn with the value of every interval that is active somewhere in [from, to], in order of start frame
+	template <typename Fn>
+	void visit(Frame from, Frame to, Fn&& fn) const
+	{
+		visit(root_, from, to, fn);
+	}
+
+private:
+	struct Node;
+	using NodePtr = std::shared_ptr<const Node>;
+	using MutableNodePtr = std::shared_ptr<Node>;
+
+	struct Node
+	{
+		explicit Node(const Interval& interval)
+			: interval(interval)
+			, maxStop(interval.stop)
+			, priority(mix(Hash()(interval.value)))
+		{}
+
+		Interval interval;
+		Frame maxStop;
+		size_t priority;
+		NodePtr left;
+		NodePtr right;
+	};
+
+	// The value hash decides the shape of the treap, so scramble it in case it is not well distributed
+	static size_t mix(size_t h) noexcept
+	{
+		uint64_t x = h + 0x9e3779b97f4a7c15ull;
+		x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+		x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+		return static_cast<size_t>(x ^ (x >> 31));
+	}
+
+	static bool less(Frame startA, const T& a, Frame startB, const T& b) noexcept
+	{
+		return startA < startB || (!(startB < startA) && a < b);
+	}
+
+	static void update(Node& node) noexcept
+	{
+		node.maxStop = node.interval.stop;
+		if (node.left) node.maxStop = std::max(node.maxStop, node.left->maxStop);
+		if (node.right) node.maxStop = std::max(node.maxStop, node.right->maxStop);
+	}
+
+	static NodePtr copy(const Node& node, NodePtr left, NodePtr right)
+	{
+		auto result = makePooled<Node>(node);
+		result->left = std::move(left);
+		result->right = std::move(right);
+		update(*result);
+		return result;
+	}
+
+	// Splits into the intervals ordered before (start, value) and the rest
+	static std::pair<NodePtr, NodePtr> split(const NodePtr& node, Frame start, const T& value)
+	{
+		if (!node) return {};
+
+		if (less(node->interval.start, node->interval.value, start, value))
+		{
+			auto right = split(node->right, start, value);
+			return { copy(*node, node->left, right.first), right.second };
+		}
+
+		auto left = split(node->left, start, value);
+		return { left.first, copy(*node, left.second, node->right) };
+	}
+
+	// Every interval in left is ordered before every interval in right
+	static NodePtr merge(const NodePtr& left, const NodePtr& right)
+	{
+		if (!left) return right;
+		if (!right) return left;
+
+		if (left->priority > right->priority) return copy(*left, left->left, merge(left->right, right));
+		return copy(*right, merge(left, right->left), right->right);
+	}
+
+	static NodePtr insert(const NodePtr& node, const MutableNodePtr& added)
+	{
+		if (!node) return added;
+
+		auto& interval = added->interval;
+		if (added->priority > node->priority)
+		{
+			auto parts = split(node, interval.start, interval.value);
+			added->left = parts.first;
+			added->right = parts.second;
+			update(*added);
+			return added;
+		}
+
+		if (less(interval.start, interval.value, node->interval.start, node->interval.value)) return copy(*node, insert(node->left, added), node->right);
+		return copy(*node, node->left, insert(node->right, added));
+	}
+
+	NodePtr erase(const NodePtr& node, Frame start, const T& value)
+	{
+		if (!node) return node;
+
+		if (less(start, value, node->interval.start, node->interval.value)) return copy(*node, erase(node->left, start, value), node->right);
+		if (less(node->interval.start, node->interval.value, start, value)) return copy(*node, node->left, erase(node->right, start, value));
+
+		size_--;
+		return merge(node->left, node->right);
+	}
+
+	// Skips subtrees that stop before from, and stops going right once the intervals start after to
+	template <typename Fn>
+	static void visit(const NodePtr& node, Frame from, Frame to, Fn& fn)
+	{
+		if (!node || node->maxStop <= from) return;
+
+		visit(node->left, from, to, fn);
+		if (to < node->interval.start) return;
+		if (from < node->interval.stop && node->interval.start < node->interval.stop) fn(node->interval.value);
+		visit(node->right, from, to, fn);
+	}
+
+	NodePtr root_;
+	size_t size_ {};
+};
+
+END_NAMESPACE(Core)
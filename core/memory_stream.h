@@ -0,0 +1,20 @@
+#pragma once
+#include "static.h"
+
+#include <streambuf>
+
+BEGIN_NAMESPACE(Core)
+
+// A read-only stream buffer over memory that is owned elsewhere, like a memory mapped file. This allows
+// deserializing a project straight from that memory instead of copying it into a string stream first.
+class MemoryStreamBuf: public std::streambuf
+{
+public:
+	MemoryStreamBuf(const char* data, size_t size) noexcept
+	{
+		auto begin = const_cast<char*>(data);
+		setg(begin, begin, begin + size);
+	}
+};
+
+END_NAMESPACE(Core)
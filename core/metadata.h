@@ -1,5 +1,6 @@
 #pragma once
 #include "static.h"
+#include "intern_table.h"
 
 BEGIN_NAMESPACE(Core)
 
@@ -72,6 +73,8 @@ private:
 	const Data data_;
 };
 
+// Every node holds its own instances of its local connectors, since documents look connectors up by pointer. The
+// data behind them is interned, so nodes that add the same connector share it.
 class ConnectorMetadata
 {
 	class Data
@@ -81,19 +84,32 @@ class ConnectorMetadata
 		ConnectorType type_;
 		bool isLocal_ { false };
 
+		friend bool operator==(const Data& lhs, const Data& rhs)
+		{
+			return lhs.hash_ == rhs.hash_ && lhs.type_ == rhs.type_ && lhs.isLocal_ == rhs.isLocal_ && lhs.title_ == rhs.title_;
+		}
+
 		friend class ConnectorMetadata;
 		friend class Builder;
 	};
+
+	struct DataHash
+	{
+		size_t operator()(const Data& data) const noexcept { return std::hash<std::string>()(data.title_) ^ (static_cast<size_t>(data.type_) << 1); }
+	};
+
+	using DataPtr = std::shared_ptr<const Data>;
+
 public:
 	explicit ConnectorMetadata(const Data&& data)
-		: data_(data)
+		: data_(intern(Data(data)))
 	{
 	}
 
-	HashValue hash() const noexcept { return data_.hash_; }
-	std::string title() const noexcept { return data_.title_; }
-	ConnectorType type() const noexcept { return data_.type_; }
-	bool isLocal() const noexcept { return data_.isLocal_; }
+	HashValue hash() const noexcept { return data_->hash_; }
+	std::string title() const noexcept { return data_->title_; }
+	ConnectorType type() const noexcept { return data_->type_; }
+	bool isLocal() const noexcept { return data_->isLocal_; }
 
 	class Builder
 	{
@@ -108,7 +124,7 @@ public:
 	};
 
 	ConnectorMetadata(Builder&& rhs)
-		: data_(std::move(rhs.data_))
+		: data_(intern(std::move(rhs.data_)))
 	{}
 
 	friend std::ostream& operator<<(std::ostream& out, const ConnectorMetadata& n);
@@ -117,18 +133,39 @@ public:
 private:
 	friend class cereal::access;
 
+	// Never destroyed, so connectors that are released during static destruction don't outlive it
+	static DataPtr intern(Data data)
+	{
+		static auto table = new InternTable<Data, DataHash>();
+		return table->intern(std::make_shared<const Data>(std::move(data)));
+	}
+
 	template<class Archive>
-	void serialize(Archive& archive)
+	void save(Archive& archive) const
 	{
-		archive(data_.hash_);
-		archive(data_.isLocal_);
-		if (!data_.isLocal_) return;
-		archive(data_.title_);
-		archive(data_.type_);
+		archive(data_->hash_);
+		archive(data_->isLocal_);
+		if (!data_->isLocal_) return;
+		archive(data_->title_);
+		archive(data_->type_);
+	}
+
+	template<class Archive>
+	void load(Archive& archive)
+	{
+		Data data;
+		archive(data.hash_);
+		archive(data.isLocal_);
+		if (data.isLocal_)
+		{
+			archive(data.title_);
+			archive(data.type_);
+		}
+		data_ = intern(std::move(data));
 	}
 
 	ConnectorMetadata() = default;
-	Data data_;
+	DataPtr data_;
 };
 
 struct Metadata
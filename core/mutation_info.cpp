@@ -1,5 +1,4 @@
 #include "mutation_info.h"
-#include "document.h"
 
 using Core::ConnectionPtr;
 using Core::ConnectorMetadataCollection;
@@ -9,7 +8,10 @@ using Core::MutationInfo;
 using Core::Node;
 using Core::NodePtr;
 using Core::PropertyPtr;
-using Core::node_eq_uuid;
+using Core::property_eq_hash;
+using Core::Uuid;
+using Core::tree_t;
+using JournalEntry = Document::JournalEntry;
 
 using ChangeType = MutationInfo::ChangeType;
 template <typename T>
@@ -17,40 +19,147 @@ using Change = MutationInfo::Change<T>;
 template <typename T>
 using ChangeSet = MutationInfo::ChangeSet<T>;
 
-template <typename Container>
-NodePtr findNodeByUuid(const Container& c, const Core::Uuid& uuid)
+// Positions of nodes in the pre-order of a document, computed only for the nodes that are asked for
+class PreOrder
 {
-	auto it = find_if(cbegin(c), cend(c), [&](auto& node) { return node->uuid() == uuid; });
-	if (it != cend(c)) return *it;
-	return nullptr;
+public:
+	explicit PreOrder(const Document& d)
+		: nodes_(d.nodes())
+	{}
+
+	const std::vector<size_t>& path(const Uuid& uuid)
+	{
+		auto it = paths_.find(uuid);
+		if (it != end(paths_)) return it->second;
+
+		std::vector<size_t> result;
+		auto entry = nodes_.entry(uuid);
+		if (entry->hasParent)
+		{
+			result = path(entry->parent);
+			result.push_back(nodes_.index(uuid));
+		}
+		return paths_.emplace(uuid, std::move(result)).first->second;
+	}
+
+	size_t index(const Uuid& uuid) const
+	{
+		return nodes_.index(uuid);
+	}
+
+	NodePtr parent(const Uuid& uuid) const
+	{
+		auto parent = nodes_.parent(uuid);
+		return parent ? *parent : nullptr;
+	}
+
+	void sort(std::vector<Uuid>& uuids)
+	{
+		std::sort(begin(uuids), end(uuids), [&](auto& a, auto& b) { return path(a) < path(b); });
+	}
+
+private:
+	const tree_t& nodes_;
+	std::unordered_map<Uuid, std::vector<size_t>> paths_;
+};
+
+// Every node that was added, removed or mutated, or whose parent or index may have changed
+std::unordered_set<Uuid> findCandidates(const Document& prev, const Document& cur)
+{
+	std::unordered_set<Uuid> candidates;
+
+	tree_t::diff(prev.nodes(), cur.nodes(), [&](const tree_t::EntryPtr& before, const tree_t::EntryPtr& after)
+	{
+		candidates.insert(before ? before->key : after->key);
+		if (!before || !after) return;
+
+		// Siblings shift when children are added, removed or moved, and children get a new parent when their parent is mutated
+		if (before->children != after->children || before->value != after->value)
+		{
+			candidates.insert(cbegin(before->children), cend(before->children));
+			candidates.insert(cbegin(after->children), cend(after->children));
+		}
+	});
+
+	return candidates;
+}
+
+// The same, but taken from what a builder recorded instead of comparing documents
+std::unordered_set<Uuid> findCandidates(const Document& prev, const Document& cur, const Document::journal_t& journal)
+{
+	std::unordered_set<Uuid> candidates;
+
+	auto addChildren = [&](const Document& d, const Uuid& uuid)
+	{
+		auto entry = d.nodes().entry(uuid);
+		if (entry) candidates.insert(cbegin(entry->children), cend(entry->children));
+	};
+
+	// Only the siblings after a node shift when it comes or goes
+	auto addSiblings = [&](const Document& d, const Uuid& uuid)
+	{
+		auto entry = d.nodes().entry(uuid);
+		if (!entry || !entry->hasParent) return;
+
+		auto& siblings = d.nodes().children(entry->parent);
+		candidates.insert(siblings.at(siblings.indexOf(entry->label) + 1), cend(siblings));
+	};
+
+	for (auto&& change : journal)
+	{
+		switch (change.type)
+		{
+		case JournalEntry::Type::NodeAdded:
+		case JournalEntry::Type::NodeRemoved:
+		case JournalEntry::Type::NodeMoved:
+			candidates.insert(change.node);
+			addSiblings(prev, change.node);
+			addSiblings(cur, change.node);
+			break;
+		case JournalEntry::Type::NodeMutated:
+			candidates.insert(change.node);
+			addChildren(prev, change.node);
+			addChildren(cur, change.node);
+			break;
+		default:
+			break;
+		}
+	}
+
+	return candidates;
 }
 
-void findRemovedNodes(const MutationInfo& i, std::vector<Change<NodePtr>>& changes)
+void findRemovedNodes(const MutationInfo& i, const std::vector<Uuid>& prevOrder, PreOrder& prevPositions, std::vector<Change<NodePtr>>& changes)
 {
-	for (auto&& prevNode: i.prevNodes)
+	for (auto&& uuid : prevOrder)
 	{
-		auto curNode = findNodeByUuid(i.curNodes, prevNode->uuid());
-		if (curNode) continue;
-		changes.emplace_back(Change<NodePtr>(prevNode, {}, ChangeType::Removed, i.prev.parent(*prevNode), {}, i.prev.childIndex(*prevNode), -1));
+		if (i.cur.find(uuid)) continue;
+		changes.emplace_back(Change<NodePtr>(i.prev.find(uuid), {}, ChangeType::Removed, prevPositions.parent(uuid), {}, prevPositions.index(uuid), -1));
 	}
 }
 
-void findAddedOrMutatedNodes(const MutationInfo& i, std::vector<Change<NodePtr>>& changes)
+void findAddedOrMutatedNodes(const MutationInfo& i, const std::vector<Uuid>& curOrder, PreOrder& prevPositions, PreOrder& curPositions, std::vector<Change<NodePtr>>& changes)
 {
-	for (auto&& curNode : i.curNodes)
+	for (auto&& uuid : curOrder)
 	{
-		auto prevNode = findNodeByUuid(i.prevNodes, curNode->uuid());
+		auto curNode = i.cur.find(uuid);
+		auto prevNode = i.prev.find(uuid);
 		if (!prevNode)
 		{
 			// added
-			changes.emplace_back(Change<NodePtr>({}, curNode, ChangeType::Added, {}, i.cur.parent(*curNode), -1, i.cur.childIndex(*curNode)));
+			changes.emplace_back(Change<NodePtr>({}, curNode, ChangeType::Added, {}, curPositions.parent(uuid), -1, curPositions.index(uuid)));
 		}
 		else
 		{
-			if (prevNode != curNode || i.prev.parent(*prevNode) != i.cur.parent(*curNode) || i.prev.childIndex(*prevNode) != i.cur.childIndex(*curNode))
+			auto prevParent = prevPositions.parent(uuid);
+			auto curParent = curPositions.parent(uuid);
+			auto prevIndex = prevPositions.index(uuid);
+			auto curIndex = curPositions.index(uuid);
+
+			if (prevNode != curNode || prevParent != curParent || prevIndex != curIndex)
 			{
 				// mutated
-				changes.emplace_back(Change<NodePtr>(prevNode, curNode, ChangeType::Mutated, i.prev.parent(*prevNode), i.cur.parent(*curNode), i.prev.childIndex(*prevNode), i.cur.childIndex(*curNode)));
+				changes.emplace_back(Change<NodePtr>(prevNode, curNode, ChangeType::Mutated, prevParent, curParent, prevIndex, curIndex));
 			}
 		}
 	}
@@ -58,32 +167,58 @@ void findAddedOrMutatedNodes(const MutationInfo& i, std::vector<Change<NodePtr>>
 
 void findRemovedConnections(const MutationInfo& i, std::vector<Change<ConnectionPtr>>& changes)
 {
+	std::unordered_set<ConnectionPtr> cur(cbegin(i.cur.connections()), cend(i.cur.connections()));
 	for (auto&& prevConn : i.prev.connections())
 	{
-		auto curConnIt = find(cbegin(i.cur.connections()), cend(i.cur.connections()), prevConn);
-		if (curConnIt != cend(i.cur.connections())) continue;
+		if (cur.count(prevConn)) continue;
 		changes.emplace_back(Change<ConnectionPtr>(prevConn, {}, ChangeType::Removed, {}, {}, -1, -1));
 	}
 }
 
 void findAddedOrMutatedConnections(const MutationInfo& i, std::vector<Change<ConnectionPtr>>& changes)
 {
+	std::unordered_set<ConnectionPtr> prev(cbegin(i.prev.connections()), cend(i.prev.connections()));
 	for (auto&& curConn : i.cur.connections())
 	{
-		auto prevConnIt = find(cbegin(i.prev.connections()), cend(i.prev.connections()), curConn);
-		if (prevConnIt != cend(i.prev.connections())) continue;
+		if (prev.count(curConn)) continue;
 		changes.emplace_back(Change<ConnectionPtr>({}, curConn, ChangeType::Added, {}, {}, -1, -1));
 	}
 }
 
+void findConnections(const Document::journal_t& journal, std::vector<Change<ConnectionPtr>>& changes)
+{
+	// Connections that were added and removed again by the same mutation cancel out, in either order
+	std::vector<ConnectionPtr> added, removed;
+	auto cancelOrRecord = [](std::vector<ConnectionPtr>& opposite, std::vector<ConnectionPtr>& recorded, const ConnectionPtr& connection)
+	{
+		auto it = find(begin(opposite), end(opposite), connection);
+		if (it != end(opposite)) opposite.erase(it);
+		else recorded.emplace_back(connection);
+	};
+
+	for (auto&& change : journal)
+	{
+		if (change.type == JournalEntry::Type::ConnectionAdded) cancelOrRecord(removed, added, change.connection);
+		else if (change.type == JournalEntry::Type::ConnectionRemoved) cancelOrRecord(added, removed, change.connection);
+	}
+
+	for (auto&& prevConn : removed) changes.emplace_back(Change<ConnectionPtr>(prevConn, {}, ChangeType::Removed, {}, {}, -1, -1));
+	for (auto&& curConn : added) changes.emplace_back(Change<ConnectionPtr>({}, curConn, ChangeType::Added, {}, {}, -1, -1));
+}
+
 template <typename ITEMPTR, typename EqFn, typename GetItemsFn>
-void findRemovedItems(const MutationInfo& i, std::vector<Change<ITEMPTR>>& changes, GetItemsFn getItems)
+void findRemovedItems(const MutationInfo& i, const std::vector<Uuid>& prevOrder, std::vector<Change<ITEMPTR>>& changes, GetItemsFn getItems)
 {
-	for (auto&& prevNode : i.prevNodes)
+	for (auto&& uuid : prevOrder)
 	{
-		auto curNode = findNodeByUuid(i.curNodes, prevNode->uuid());
-		for (auto&& prevItem : getItems(prevNode))
+		auto prevNode = i.prev.find(uuid);
+		auto curNode = i.cur.find(uuid);
+		if (prevNode == curNode) continue; // same node, so the same items
+
+		auto prevNodeItems = getItems(prevNode);
+		for (size_t index = 0; index < prevNodeItems.size(); index++)
 		{
+			auto&& prevItem = prevNodeItems[index];
 			bool removed = false;
 
 			if (curNode)
@@ -100,21 +235,27 @@ void findRemovedItems(const MutationInfo& i, std::vector<Change<ITEMPTR>>& chang
 				removed = true;
 			}
 
-			if (removed) changes.emplace_back(Change<ITEMPTR>(prevItem, {}, ChangeType::Removed, prevNode, {}, i.prev.childIndex(*prevItem), -1));
+			if (removed) changes.emplace_back(Change<ITEMPTR>(prevItem, {}, ChangeType::Removed, prevNode, {}, index, -1));
 		}
 	}
 }
 
 template <typename ITEMPTR, typename EqFn, typename GetItemsFn>
-void findAddedOrMutatedItems(const MutationInfo& i, std::vector<Change<ITEMPTR>>& changes, GetItemsFn getItems)
+void findAddedOrMutatedItems(const MutationInfo& i, const std::vector<Uuid>& curOrder, std::vector<Change<ITEMPTR>>& changes, GetItemsFn getItems)
 {
-	for (auto&& curNode : i.curNodes)
+	for (auto&& uuid : curOrder)
 	{
-		auto prevNode = findNodeByUuid(i.prevNodes, curNode->uuid());
-		for (auto&& curItem : getItems(curNode))
+		auto prevNode = i.prev.find(uuid);
+		auto curNode = i.cur.find(uuid);
+		if (prevNode == curNode) continue; // same node, so the same items
+
+		auto curNodeItems = getItems(curNode);
+		for (size_t index = 0; index < curNodeItems.size(); index++)
 		{
+			auto&& curItem = curNodeItems[index];
 			bool added = false;
 			ITEMPTR prevItem {};
+			size_t prevIndex = -1;
 
 			if (prevNode)
 			{
@@ -125,7 +266,11 @@ void findAddedOrMutatedItems(const MutationInfo& i, std::vector<Change<ITEMPTR>>
 				});
 
 				if (itemIt == cend(prevNodeItems)) added = true;
-				else prevItem = *itemIt;
+				else
+				{
+					prevItem = *itemIt;
+					prevIndex = distance(cbegin(prevNodeItems), itemIt);
+				}
 			}
 			else
 			{
@@ -135,38 +280,67 @@ void findAddedOrMutatedItems(const MutationInfo& i, std::vector<Change<ITEMPTR>>
 			if (added)
 			{
 				// added
-				changes.emplace_back(Change<ITEMPTR>({}, curItem, ChangeType::Added, {}, curNode, -1, i.cur.childIndex(*curItem)));
+				changes.emplace_back(Change<ITEMPTR>({}, curItem, ChangeType::Added, {}, curNode, -1, index));
 			}
 			else
 			{
 				if (prevItem != curItem)
 				{
 					// mutated
-					changes.emplace_back(Change<ITEMPTR>(prevItem, curItem, ChangeType::Mutated, prevNode, curNode, i.prev.childIndex(*prevItem), i.cur.childIndex(*curItem)));
+					changes.emplace_back(Change<ITEMPTR>(prevItem, curItem, ChangeType::Mutated, prevNode, curNode, prevIndex, index));
 				}
 			}
 		}
 	}
 }
 
-MutationInfo::MutationInfo(const Document& prev, const Document& cur)
-	: prev(prev)
-	, cur(cur)
+void findChanges(MutationInfo& i, const std::unordered_set<Uuid>& candidates)
 {
-	for (auto&& node : prev.nodes()) if (node != prev.root()) prevNodes.emplace_back(node);
-	for (auto&& node : cur.nodes()) if (node != cur.root()) curNodes.emplace_back(node);
+	// Only look at the candidates, in the order they appear in each document. The roots are never reported.
+	std::vector<Uuid> prevOrder, curOrder;
+	for (auto&& uuid : candidates)
+	{
+		auto prevNode = i.prev.find(uuid);
+		auto curNode = i.cur.find(uuid);
+		if (prevNode && prevNode != i.prev.root()) prevOrder.emplace_back(uuid);
+		if (curNode && curNode != i.cur.root()) curOrder.emplace_back(uuid);
+	}
 
-	findRemovedNodes(*this, nodes);
-	findAddedOrMutatedNodes(*this, nodes);
+	PreOrder prevPositions(i.prev);
+	PreOrder curPositions(i.cur);
+	prevPositions.sort(prevOrder);
+	curPositions.sort(curOrder);
+
+	findRemovedNodes(i, prevOrder, prevPositions, i.nodes);
+	findAddedOrMutatedNodes(i, curOrder, prevPositions, curPositions, i.nodes);
 
 	auto getProperties = [&](const NodePtr& n) { return n->properties(); };
-	findRemovedItems<PropertyPtr, property_eq_hash>(*this, properties, getProperties);
-	findAddedOrMutatedItems<PropertyPtr, property_eq_hash>(*this, properties, getProperties);
+	findRemovedItems<PropertyPtr, property_eq_hash>(i, prevOrder, i.properties, getProperties);
+	findAddedOrMutatedItems<PropertyPtr, property_eq_hash>(i, curOrder, i.properties, getProperties);
 
 	auto getConnectors = [&](const NodePtr& n) { return n->connectorMetadata(); };
-	findRemovedItems<ConnectorMetadataPtr, connector_metadata_eq_hash>(*this, connectors, getConnectors);
-	findAddedOrMutatedItems<ConnectorMetadataPtr, connector_metadata_eq_hash>(*this, connectors, getConnectors);
+	findRemovedItems<ConnectorMetadataPtr, connector_metadata_eq_hash>(i, prevOrder, i.connectors, getConnectors);
+	findAddedOrMutatedItems<ConnectorMetadataPtr, connector_metadata_eq_hash>(i, curOrder, i.connectors, getConnectors);
+}
 
-	findRemovedConnections(*this, connections);
-	findAddedOrMutatedConnections(*this, connections);
+MutationInfo::MutationInfo(const Document& prev, const Document& cur)
+	: prev(prev)
+	, cur(cur)
+{
+	findChanges(*this, findCandidates(prev, cur));
+
+	// Documents that share their connections can not have changed them
+	if (&prev.connections() != &cur.connections())
+	{
+		findRemovedConnections(*this, connections);
+		findAddedOrMutatedConnections(*this, connections);
+	}
+}
+
+MutationInfo::MutationInfo(const Document& prev, const Document& cur, const Document::journal_t& journal)
+	: prev(prev)
+	, cur(cur)
+{
+	findChanges(*this, findCandidates(prev, cur, journal));
+	findConnections(journal, connections);
 }
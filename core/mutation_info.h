@@ -1,11 +1,13 @@
 #pragma once
 #include "static.h"
+#include "document.h"
 
 BEGIN_NAMESPACE(Core)
 
 struct MutationInfo
 {
 	MutationInfo(const Document& prev, const Document& cur);
+	MutationInfo(const Document& prev, const Document& cur, const Document::journal_t& journal);
 
 	enum class ChangeType { Added, Removed, Mutated };
 
@@ -79,9 +81,6 @@ struct MutationInfo
 
 	const Document& prev;
 	const Document& cur;
-
-	std::vector<NodePtr> prevNodes;
-	std::vector<NodePtr> curNodes;
 };
 
 END_NAMESPACE(Core)
\ No newline at end of file
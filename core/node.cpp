@@ -13,9 +13,11 @@ using Core::ConnectorMetadataCollection;
 using Core::ConnectorMetadataPtr;
 using Core::PropertyMetadata;
 using Core::visibility_t;
+using Core::makePooled;
+using Core::PoolAllocated;
 using Builder = Node::Builder;
 
-struct Node::Impl
+struct Node::Impl: PoolAllocated
 {
 	Uuid uuid_;
 	HashValue nodeType_;
@@ -49,7 +51,7 @@ void Node::setNodeType(HashValue nodeType)
 	{
 		for (auto&& meta : metadata->propertyMetadataCollection)
 		{
-			auto p = std::make_shared<Property>(nodeType, meta->hash());
+			auto p = makePooled<Property>(nodeType, meta->hash());
 			impl_->properties_.emplace_back(p);
 		}
 
@@ -142,7 +144,7 @@ Node& Node::operator=(Builder&& rhs)
 void Builder::addProperty(PropertyMetadata::Builder&& propertyMetadata) noexcept
 {
 	auto meta = propertyMetadata.build();
-	auto p = std::make_shared<Property>(impl_->nodeType_, meta->hash(), meta);
+	auto p = makePooled<Property>(impl_->nodeType_, meta->hash(), meta);
 	impl_->properties_.emplace_back(p);
 }
 
@@ -160,7 +162,7 @@ void Builder::mutateProperty(PropertyPtr prop, mutate_fn fn) noexcept
 
 	// Replace property
 	auto it = find(begin(impl_->properties_), end(impl_->properties_), prop);
-	*it = std::make_shared<Property>(std::move(b));
+	*it = makePooled<Property>(std::move(b));
 }
 
 void Builder::addConnector(ConnectorMetadata::Builder&& connector) noexcept
@@ -208,3 +210,5 @@ void Node::load(Archive& archive)
 
 template void Node::save<cereal::JSONOutputArchive>(cereal::JSONOutputArchive& archive) const;
 template void Node::load<cereal::JSONInputArchive>(cereal::JSONInputArchive& archive);
+template void Node::save<cereal::PortableBinaryOutputArchive>(cereal::PortableBinaryOutputArchive& archive) const;
+template void Node::load<cereal::PortableBinaryInputArchive>(cereal::PortableBinaryInputArchive& archive);
@@ -0,0 +1,382 @@
+#pragma once
+#include "static.h"
+#include "pool.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+BEGIN_NAMESPACE(Core)
+
+// An immutable sequence of keys, stored as a treap ordered on a label per key where every node also knows the size
+// of its subtree. Copying is O(1), and inserting, erasing and indexing are O(log N), since only the nodes on the path
+// are copied. The labels are what lets the owner of a key find its index in O(log N) without searching for it.
+// They are kept spread out, and when an insert runs out of room between two labels, the smallest surrounding range
+// of labels that is sparse enough is spread out again (Bender et al., "Two simplified algorithms for maintaining
+// order in a list"). That changes O(log N) labels amortized.
+template <typename Key, typename Hash = std::hash<Key>>
+class PersistentList
+{
+	struct Node;
+	using NodePtr = std::shared_ptr<const Node>;
+	using MutableNodePtr = std::shared_ptr<Node>;
+
+public:
+	using label_t = uint64_t;
+	using value_type = Key;
+
+	PersistentList() = default;
+
+	// Builds the list in one go, which is O(N). The key at index i gets spacedLabel(i).
+	explicit PersistentList(const std::vector<Key>& keys)
+	{
+		std::vector<std::pair<Key, label_t>> labeled;
+		labeled.reserve(keys.size());
+		for (size_t i = 0; i < keys.size(); i++) labeled.emplace_back(keys[i], spacedLabel(i));
+		root_ = build(labeled);
+	}
+
+	static label_t spacedLabel(size_t index) noexcept { return (static_cast<label_t>(index) + 1) << spacing; }
+
+	size_t size() const noexcept { return size(root_); }
+	bool empty() const noexcept { return !root_; }
+
+	const Key& operator[](size_t index) const noexcept { return select(index)->key; }
+	const Key& front() const noexcept { return (*this)[0]; }
+	const Key& back() const noexcept { return (*this)[size() - 1]; }
+
+	// The index of the key that has label
+	size_t indexOf(label_t label) const noexcept
+	{
+		assert(rank(label) < size() && select(rank(label))->label == label);
+		return rank(label);
+	}
+
+	// Estimate of what a changed version of the list holds on to on top of the original, which is one path
+	size_t pathBytes() const noexcept
+	{
+		size_t depth = 1;
+		for (auto n = size(); n > 1; n >>= 1) depth++;
+		return depth * sizeof(Node);
+	}
+
+	// In-order iteration, which keeps the path to the current key
+	class const_iterator
+	{
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = Key;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const Key*;
+		using reference = const Key&;
+
+		const_iterator() = default;
+
+		reference operator*() const noexcept { return path_.back()->key; }
+		pointer operator->() const noexcept { return &path_.back()->key; }
+
+		const_iterator& operator++() noexcept
+		{
+			auto node = path_.back();
+			path_.pop_back();
+			for (auto n = node->right.get(); n; n = n->left.get()) path_.push_back(n);
+			return *this;
+		}
+
+		const_iterator operator++(int) noexcept
+		{
+			auto result = *this;
+			++*this;
+			return result;
+		}
+
+		bool operator==(const const_iterator& rhs) const noexcept { return current() == rhs.current(); }
+		bool operator!=(const const_iterator& rhs) const noexcept { return current() != rhs.current(); }
+
+	private:
+		friend class PersistentList;
+
+		const Node* current() const noexcept { return path_.empty() ? nullptr : path_.back(); }
+
+		// The nodes that are still to be visited and have had their left subtree visited, the current one last
+		std::vector<const Node*> path_;
+	};
+
+	const_iterator begin() const noexcept { return at(0); }
+	const_iterator end() const noexcept { return const_iterator(); }
+	const_iterator cbegin() const noexcept { return begin(); }
+	const_iterator cend() const noexcept { return end(); }
+
+	// Iterator to the key at index, or end() if index is past the end
+	const_iterator at(size_t index) const noexcept
+	{
+		const_iterator it;
+		for (auto node = root_.get(); node;)
+		{
+			auto left = size(node->left);
+			if (index < left)
+			{
+				it.path_.push_back(node);
+				node = node->left.get();
+			}
+			else if (index == left)
+			{
+				it.path_.push_back(node);
+				break;
+			}
+			else
+			{
+				index -= left + 1;
+				node = node->right.get();
+			}
+		}
+		return it;
+	}
+
+	// Inserts key so it ends up at index, and returns the label it got. Keys that had to get a new label to make room
+	// are passed to relabeled(key, label).
+	template <typename Fn>
+	label_t insert(size_t index, const Key& key, Fn&& relabeled)
+	{
+		assert(index <= size());
+		auto prev = index > 0 ? select(index - 1) : nullptr;
+		auto next = index < size() ? select(index) : nullptr;
+
+		const label_t step = label_t(1) << spacing;
+		const label_t last = ~label_t(0);
+
+		label_t label;
+		if (!prev && !next) label = spacedLabel(0);
+		else if (!prev && next->label > step) label = next->label - step;
+		else if (!prev && next->label > 0) label = next->label / 2;
+		else if (!next && prev->label <= last - step) label = prev->label + step;
+		else if (!next && prev->label < last) label = prev->label + (last - prev->label + 1) / 2;
+		else if (prev && next && next->label - prev->label >= 2) label = prev->label + (next->label - prev->label) / 2;
+		else return relabel(index, key, prev ? prev->label : next->label, relabeled);
+
+		root_ = insert(root_, makePooled<Node>(key, label));
+		return label;
+	}
+
+	void erase(size_t index) noexcept
+	{
+		assert(index < size());
+		root_ = erase(root_, select(index)->label);
+	}
+
+	// Lists are only compared on whether they share their storage, which is all that diffing documents needs
+	friend bool operator==(const PersistentList& lhs, const PersistentList& rhs) noexcept { return lhs.root_ == rhs.root_; }
+	friend bool operator!=(const PersistentList& lhs, const PersistentList& rhs) noexcept { return lhs.root_ != rhs.root_; }
+
+private:
+	// Labels are handed out this far apart, so appending and prepending rarely run out of room
+	static const unsigned spacing = 32;
+
+	struct Node
+	{
+		Node(const Key& key, label_t label)
+			: key(key)
+			, label(label)
+			, priority(mix(Hash()(key)))
+		{}
+
+		Key key;
+		label_t label;
+		size_t priority;
+		size_t size { 1 };
+		NodePtr left;
+		NodePtr right;
+	};
+
+	// The key hash decides the shape of the treap, so scramble it in case it is not well distributed
+	static size_t mix(size_t h) noexcept
+	{
+		uint64_t x = h + 0x9e3779b97f4a7c15ull;
+		x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+		x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+		return static_cast<size_t>(x ^ (x >> 31));
+	}
+
+	static size_t size(const NodePtr& node) noexcept { return node ? node->size : 0; }
+
+	static void update(Node& node) noexcept
+	{
+		node.size = 1 + size(node.left) + size(node.right);
+	}
+
+	static NodePtr copy(const Node& node, NodePtr left, NodePtr right)
+	{
+		auto result = makePooled<Node>(node);
+		result->left = std::move(left);
+		result->right = std::move(right);
+		update(*result);
+		return result;
+	}
+
+	const Node* select(size_t index) const noexcept
+	{
+		auto node = root_.get();
+		while (node)
+		{
+			auto left = size(node->left);
+			if (index < left) node = node->left.get();
+			else if (index == left) return node;
+			else
+			{
+				index -= left + 1;
+				node = node->right.get();
+			}
+		}
+		assert(false);
+		return nullptr;
+	}
+
+	// Number of keys with a lower label
+	size_t rank(label_t label) const noexcept
+	{
+		size_t result = 0;
+		for (auto node = root_.get(); node;)
+		{
+			if (node->label < label)
+			{
+				result += size(node->left) + 1;
+				node = node->right.get();
+			}
+			else node = node->left.get();
+		}
+		return result;
+	}
+
+	// Splits into the keys with a lower label and the rest
+	static std::pair<NodePtr, NodePtr> split(const NodePtr& node, label_t label)
+	{
+		if (!node) return {};
+
+		if (node->label < label)
+		{
+			auto right = split(node->right, label);
+			return { copy(*node, node->left, right.first), right.second };
+		}
+
+		auto left = split(node->left, label);
+		return { left.first, copy(*node, left.second, node->right) };
+	}
+
+	// Every label in left is lower than every label in right
+	static NodePtr merge(const NodePtr& left, const NodePtr& right)
+	{
+		if (!left) return right;
+		if (!right) return left;
+
+		if (left->priority > right->priority) return copy(*left, left->left, merge(left->right, right));
+		return copy(*right, merge(left, right->left), right->right);
+	}
+
+	static NodePtr insert(const NodePtr& node, const MutableNodePtr& added)
+	{
+		if (!node) return added;
+
+		if (added->priority > node->priority)
+		{
+			auto parts = split(node, added->label);
+			added->left = parts.first;
+			added->right = parts.second;
+			update(*added);
+			return added;
+		}
+
+		if (added->label < node->label) return copy(*node, insert(node->left, added), node->right);
+		return copy(*node, node->left, insert(node->right, added));
+	}
+
+	static NodePtr erase(const NodePtr& node, label_t label)
+	{
+		assert(node);
+		if (label < node->label) return copy(*node, erase(node->left, label), node->right);
+		if (node->label < label) return copy(*node, node->left, erase(node->right, label));
+		return merge(node->left, node->right);
+	}
+
+	// Cartesian tree construction from keys in label order: the stack holds the right spine of the tree built so far.
+	// Nodes that get popped off it are complete, so that is when their size is known.
+	static NodePtr build(const std::vector<std::pair<Key, label_t>>& keys)
+	{
+		std::vector<MutableNodePtr> spine;
+		for (auto&& key : keys)
+		{
+			auto node = makePooled<Node>(key.first, key.second);
+			MutableNodePtr last;
+			while (!spine.empty() && spine.back()->priority < node->priority)
+			{
+				last = spine.back();
+				spine.pop_back();
+				update(*last);
+			}
+
+			node->left = last;
+			if (!spine.empty()) spine.back()->right = node;
+			spine.push_back(node);
+		}
+
+		for (auto it = spine.rbegin(); it != spine.rend(); ++it) update(**it);
+		return spine.empty() ? nullptr : spine.front();
+	}
+
+	// Spreads out the labels of the smallest aligned range around anchor that stays sparse enough with key added to
+	// it. A range of 2^bits labels may hold up to (4/3)^bits keys, so the labels end up at least 1.5^bits apart.
+	template <typename Fn>
+	label_t relabel(size_t index, const Key& key, label_t anchor, Fn& relabeled)
+	{
+		for (unsigned bits = 1; bits <= 64; bits++)
+		{
+			auto mask = bits == 64 ? ~label_t(0) : (label_t(1) << bits) - 1;
+			auto first = anchor & ~mask;
+			auto last = first + mask;
+
+			auto from = rank(first);
+			auto to = last == ~label_t(0) ? size() : rank(last + 1);
+			auto count = to - from + 1;
+			if (bits < 64 && count > std::pow(4.0 / 3.0, bits)) continue;
+
+			auto parts = split(root_, first);
+			auto rest = last == ~label_t(0) ? std::make_pair(parts.second, NodePtr()) : split(parts.second, last + 1);
+
+			// Collect the range with key in its place, and label it evenly
+			std::vector<std::pair<Key, label_t>> keys;
+			keys.reserve(count);
+			collect(rest.first.get(), keys);
+			keys.emplace(keys.begin() + (index - from), key, label_t());
+
+			auto gap = mask / count;
+			for (size_t i = 0; i < keys.size(); i++)
+			{
+				auto label = first + gap / 2 + gap * i;
+				if (i != index - from && keys[i].second != label) relabeled(keys[i].first, label);
+				keys[i].second = label;
+			}
+
+			root_ = merge(parts.first, merge(build(keys), rest.second));
+			return keys[index - from].second;
+		}
+
+		assert(false);
+		return 0;
+	}
+
+	static void collect(const Node* node, std::vector<std::pair<Key, label_t>>& out)
+	{
+		if (!node) return;
+		collect(node->left.get(), out);
+		out.emplace_back(node->key, node->label);
+		collect(node->right.get(), out);
+	}
+
+	NodePtr root_;
+};
+
+END_NAMESPACE(Core)
@@ -0,0 +1,668 @@
+#pragma once
+#include "static.h"
+#include "pool.h"
+#include "persistent_list.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+BEGIN_NAMESPACE(Core)
+
+// An immutable tree with structural sharing. Every node is stored as an entry (value, parent key and child keys)
+// in a hash array mapped trie that is keyed on a unique key per node. Copying a tree is O(1), and changing a value
+// only copies the path through the trie to that entry, so it costs O(log32 N) regardless of the depth of the tree.
+// Child lists are persistent lists, so structural changes also cost O(log N) in the number of siblings involved.
+// Every entry keeps its label in the child list of its parent, so finding its index doesn't search the siblings.
+// Branches that are only referenced by this tree (because an earlier change already copied them) are updated in
+// place instead of being copied again.
+template <typename Key, typename T, typename Hash = std::hash<Key>>
+class PersistentTree
+{
+public:
+	using children_t = PersistentList<Key, Hash>;
+	using label_t = typename children_t::label_t;
+
+	struct Entry
+	{
+		Key key;
+		T value;
+		Key parent;
+		bool hasParent;
+		children_t children;
+		label_t label {}; // of the entry in the child list of its parent
+	};
+
+	using EntryPtr = std::shared_ptr<const Entry>;
+
+	class const_iterator;
+	using iterator = const_iterator;
+	using value_type = T;
+
+	PersistentTree() = default;
+
+	size_t size() const noexcept { return size_; }
+	bool empty() const noexcept { return size_ == 0; }
+
+	const_iterator begin() const noexcept { return hasHead_ ? const_iterator(this, entry(head_)) : end(); }
+	const_iterator end() const noexcept { return const_iterator(); }
+	const_iterator cbegin() const noexcept { return begin(); }
+	const_iterator cend() const noexcept { return end(); }
+
+	const Entry* entry(const Key& key) const noexcept
+	{
+		auto slot = lookup(key);
+		return slot ? slot->get() : nullptr;
+	}
+
+	const T* find(const Key& key) const noexcept
+	{
+		auto e = entry(key);
+		return e ? &e->value : nullptr;
+	}
+
+	const T& head() const noexcept
+	{
+		assert(hasHead_);
+		return entry(head_)->value;
+	}
+
+	const T* parent(const Key& key) const noexcept
+	{
+		auto e = entry(key);
+		assert(e);
+		return e->hasParent ? find(e->parent) : nullptr;
+	}
+
+	const children_t& children(const Key& key) const noexcept
+	{
+		auto e = entry(key);
+		assert(e);
+		return e->children;
+	}
+
+	size_t index(const Key& key) const noexcept
+	{
+		auto e = entry(key);
+		assert(e);
+		return e->hasParent ? children(e->parent).indexOf(e->label) : 0;
+	}
+
+	// Number of nodes in the subtree at key, including the node itself
+	size_t subtreeSize(const Key& key) const noexcept
+	{
+		size_t result = 1;
+		for (auto& child : children(key)) result += subtreeSize(child);
+		return result;
+	}
+
+	void setHead(const Key& key, T value)
+	{
+		assert(!hasHead_);
+		put(makePooled<Entry>(Entry { key, std::move(value), Key(), false, {} }));
+		head_ = key;
+		hasHead_ = true;
+	}
+
+	void replace(const Key& key, T value)
+	{
+		auto slot = lookup(key);
+		assert(slot);
+
+		auto e = makePooled<Entry>(**slot);
+		e->value = std::move(value);
+		put(e);
+	}
+
+	void appendChild(const Key& parent, const Key& key, T value)
+	{
+		assert(!entry(key));
+		auto label = insertChild(parent, children(parent).size(), key);
+		put(makePooled<Entry>(Entry { key, std::move(value), parent, true, {}, label }));
+	}
+
+	void insertBefore(const Key& before, const Key& key, T value)
+	{
+		auto b = entry(before);
+		assert(b && b->hasParent);
+		assert(!entry(key));
+
+		auto parent = b->parent;
+		auto label = insertChild(parent, index(before), key);
+		put(makePooled<Entry>(Entry { key, std::move(value), parent, true, {}, label }));
+	}
+
+	// Moves the subtree at key so it becomes the next sibling of after
+	void moveAfter(const Key& after, const Key& key)
+	{
+		auto a = entry(after);
+		assert(a && a->hasParent);
+		auto parent = a->parent;
+
+		detach(key);
+		auto label = insertChild(parent, index(after) + 1, key);
+		setParent(key, parent, label);
+	}
+
+	// Moves the subtree at key so it becomes the last child of parent
+	void reparent(const Key& parent, const Key& key)
+	{
+		detach(key);
+		auto label = insertChild(parent, children(parent).size(), key);
+		setParent(key, parent, label);
+	}
+
+	void erase(const Key& key)
+	{
+		detach(key);
+		removeSubtree(key);
+	}
+
+	void eraseChildren(const Key& key)
+	{
+		auto e = entry(key);
+		assert(e);
+		if (e->children.empty()) return;
+
+		auto copy = makePooled<Entry>(*e);
+		for (auto& child : copy->children) removeSubtree(child);
+		copy->children = children_t();
+		put(copy);
+	}
+
+	// Pre-order iteration, which matches the order the nodes would be displayed in
+	class const_iterator
+	{
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const T*;
+		using reference = const T&;
+
+		const_iterator() = default;
+
+		reference operator*() const noexcept { return current_->value; }
+		pointer operator->() const noexcept { return &current_->value; }
+		const Key& key() const noexcept { return current_->key; }
+		const Entry& entry() const noexcept { return *current_; }
+
+		const_iterator& operator++() noexcept
+		{
+			if (!current_->children.empty())
+			{
+				stack_.push_back({ current_->children.begin(), current_->children.end() });
+				current_ = tree_->entry(*stack_.back().sibling);
+				return *this;
+			}
+
+			while (!stack_.empty())
+			{
+				auto& top = stack_.back();
+				if (++top.sibling != top.end)
+				{
+					current_ = tree_->entry(*top.sibling);
+					return *this;
+				}
+				stack_.pop_back();
+			}
+
+			current_ = nullptr;
+			return *this;
+		}
+
+		const_iterator operator++(int) noexcept
+		{
+			auto result = *this;
+			++*this;
+			return result;
+		}
+
+		bool operator==(const const_iterator& rhs) const noexcept { return current_ == rhs.current_; }
+		bool operator!=(const const_iterator& rhs) const noexcept { return current_ != rhs.current_; }
+
+	private:
+		friend class PersistentTree;
+
+		struct Level
+		{
+			typename children_t::const_iterator sibling;
+			typename children_t::const_iterator end;
+		};
+
+		const_iterator(const PersistentTree* tree, const Entry* current)
+			: tree_(tree)
+			, current_(current)
+		{}
+
+		const PersistentTree* tree_ {};
+		const Entry* current_ {};
+		std::vector<Level> stack_;
+	};
+
+	// Calls fn(before, after) for every entry that differs between the two trees, with nullptr for entries that only
+	// exist on one side. Parts of the trie that are shared between the trees are skipped, so this is O(changes).
+	// Returns the number of bytes taken by trie branches of to that are not shared with from.
+	template <typename Fn>
+	static size_t diff(const PersistentTree& from, const PersistentTree& to, Fn&& fn)
+	{
+		return diffBranches(from.root_.get(), to.root_.get(), 0, fn);
+	}
+
+	// Stores an entry as-is, without updating its parent or children. Meant for replaying the output of diff, or for
+	// building a tree in one pass from entries that already know their parent and children.
+	void setEntry(const EntryPtr& e)
+	{
+		put(e);
+		if (!e->hasParent)
+		{
+			head_ = e->key;
+			hasHead_ = true;
+		}
+	}
+
+	// Removes a single entry as-is, without touching its parent or children. Meant for replaying the output of diff.
+	void removeEntry(const Key& key)
+	{
+		if (hasHead_ && head_ == key) hasHead_ = false;
+		remove(key);
+	}
+
+private:
+	struct Branch;
+	using BranchPtr = std::shared_ptr<const Branch>;
+
+	// Either an entry or a branch with entries that share the same hash prefix
+	struct Slot
+	{
+		EntryPtr entry;
+		BranchPtr branch;
+	};
+
+	struct Branch
+	{
+		uint32_t bitmap {};
+		std::vector<Slot> slots;
+		std::vector<EntryPtr> collisions; // entries with identical hashes, once all bits have been used
+	};
+
+	static constexpr unsigned bitsPerLevel = 5;
+	static constexpr unsigned hashBits = sizeof(size_t) * 8;
+
+	static unsigned popcount(uint32_t v) noexcept
+	{
+		v = v - ((v >> 1) & 0x55555555);
+		v = (v & 0x33333333) + ((v >> 2) & 0x33333333);
+		return (((v + (v >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+	}
+
+	static uint32_t bitFor(size_t hash, unsigned shift) noexcept
+	{
+		return 1u << ((hash >> shift) & 31);
+	}
+
+	const EntryPtr* lookup(const Key& key) const noexcept
+	{
+		auto hash = Hash()(key);
+		auto branch = root_.get();
+
+		for (unsigned shift = 0; branch; shift += bitsPerLevel)
+		{
+			if (shift >= hashBits)
+			{
+				for (auto& e : branch->collisions) if (e->key == key) return &e;
+				return nullptr;
+			}
+
+			auto bit = bitFor(hash, shift);
+			if (!(branch->bitmap & bit)) return nullptr;
+
+			auto& slot = branch->slots[popcount(branch->bitmap & (bit - 1))];
+			if (slot.entry) return slot.entry->key == key ? &slot.entry : nullptr;
+			branch = slot.branch.get();
+		}
+
+		return nullptr;
+	}
+
+	// A branch can be changed in place if nothing but this tree can reach it, which requires every branch on the
+	// path from the root to be referenced once
+	static std::shared_ptr<Branch> mutableBranch(const BranchPtr& branch, bool owned)
+	{
+		if (!branch) return makePooled<Branch>();
+		if (owned && branch.use_count() == 1) return std::const_pointer_cast<Branch>(branch);
+		return makePooled<Branch>(*branch);
+	}
+
+	static BranchPtr assoc(const BranchPtr& branch, unsigned shift, size_t hash, const EntryPtr& e, bool& added, bool owned = false)
+	{
+		auto copy = mutableBranch(branch, owned);
+
+		if (shift >= hashBits)
+		{
+			auto it = std::find_if(copy->collisions.begin(), copy->collisions.end(), [&](auto& c) { return c->key == e->key; });
+			if (it != copy->collisions.end()) *it = e;
+			else
+			{
+				copy->collisions.push_back(e);
+				added = true;
+			}
+			return copy;
+		}
+
+		auto bit = bitFor(hash, shift);
+		auto index = popcount(copy->bitmap & (bit - 1));
+
+		if (!(copy->bitmap & bit))
+		{
+			copy->slots.insert(copy->slots.begin() + index, Slot { e, nullptr });
+			copy->bitmap |= bit;
+			added = true;
+			return copy;
+		}
+
+		auto& slot = copy->slots[index];
+		if (slot.branch)
+		{
+			slot.branch = assoc(slot.branch, shift + bitsPerLevel, hash, e, added, copy == branch);
+		}
+		else if (slot.entry->key == e->key)
+		{
+			slot.entry = e;
+		}
+		else
+		{
+			// Two different keys share this prefix, push both of them down a level
+			bool ignored = false;
+			auto split = assoc(nullptr, shift + bitsPerLevel, Hash()(slot.entry->key), slot.entry, ignored);
+			slot = Slot { nullptr, assoc(split, shift + bitsPerLevel, hash, e, added) };
+		}
+
+		return copy;
+	}
+
+	static BranchPtr dissoc(const BranchPtr& branch, unsigned shift, size_t hash, const Key& key, bool& removed, bool owned = false)
+	{
+		if (!branch) return branch;
+		owned = owned && branch.use_count() == 1;
+
+		if (shift >= hashBits)
+		{
+			auto it = std::find_if(branch->collisions.begin(), branch->collisions.end(), [&](auto& c) { return c->key == key; });
+			if (it == branch->collisions.end()) return branch;
+
+			auto index = std::distance(branch->collisions.begin(), it);
+			auto copy = mutableBranch(branch, owned);
+			copy->collisions.erase(copy->collisions.begin() + index);
+			removed = true;
+			return copy;
+		}
+
+		auto bit = bitFor(hash, shift);
+		if (!(branch->bitmap & bit)) return branch;
+
+		auto index = popcount(branch->bitmap & (bit - 1));
+		auto& slot = branch->slots[index];
+
+		if (slot.entry)
+		{
+			if (slot.entry->key != key) return branch;
+
+			auto copy = mutableBranch(branch, owned);
+			copy->slots.erase(copy->slots.begin() + index);
+			copy->bitmap &= ~bit;
+			removed = true;
+			return copy;
+		}
+
+		auto sub = dissoc(slot.branch, shift + bitsPerLevel, hash, key, removed, owned);
+		if (sub == slot.branch && !removed) return branch;
+
+		auto copy = mutableBranch(branch, owned);
+		auto single = singleEntry(*sub);
+
+		if (!sub->bitmap && sub->collisions.empty())
+		{
+			copy->slots.erase(copy->slots.begin() + index);
+			copy->bitmap &= ~bit;
+		}
+		else if (single) copy->slots[index] = Slot { single, nullptr };
+		else copy->slots[index].branch = sub;
+
+		return copy;
+	}
+
+	// Returns the entry if the branch holds nothing else, so it can be pulled up a level
+	static EntryPtr singleEntry(const Branch& branch) noexcept
+	{
+		if (branch.collisions.size() == 1 && !branch.bitmap) return branch.collisions.front();
+		if (branch.collisions.empty() && branch.slots.size() == 1 && branch.slots.front().entry) return branch.slots.front().entry;
+		return nullptr;
+	}
+
+	static size_t branchBytes(const Branch& branch) noexcept
+	{
+		return sizeof(Branch) + branch.slots.capacity() * sizeof(Slot) + branch.collisions.capacity() * sizeof(EntryPtr);
+	}
+
+	static size_t subtreeBytes(const Branch* branch) noexcept
+	{
+		if (!branch) return 0;
+
+		auto result = branchBytes(*branch);
+		for (auto& slot : branch->slots) result += subtreeBytes(slot.branch.get());
+		return result;
+	}
+
+	static void collect(const Branch* branch, std::vector<EntryPtr>& out)
+	{
+		if (!branch) return;
+
+		for (auto& slot : branch->slots)
+		{
+			if (slot.entry) out.push_back(slot.entry);
+			else collect(slot.branch.get(), out);
+		}
+		out.insert(out.end(), branch->collisions.begin(), branch->collisions.end());
+	}
+
+	static void collect(const Slot* slot, std::vector<EntryPtr>& out)
+	{
+		if (!slot) return;
+		if (slot->entry) out.push_back(slot->entry);
+		else collect(slot->branch.get(), out);
+	}
+
+	template <typename Fn>
+	static void diffEntries(const std::vector<EntryPtr>& before, const std::vector<EntryPtr>& after, Fn& fn)
+	{
+		// Unless hashes collide, one side is either empty or a single entry, so a linear search is fine
+		auto findKey = [](const std::vector<EntryPtr>& entries, const Key& key)
+		{
+			return std::find_if(entries.begin(), entries.end(), [&](auto& e) { return e->key == key; });
+		};
+
+		if (before.empty())
+		{
+			for (auto& a : after) fn(EntryPtr(), a);
+			return;
+		}
+
+		if (after.empty())
+		{
+			for (auto& b : before) fn(b, EntryPtr());
+			return;
+		}
+
+		for (auto& b : before)
+		{
+			auto a = findKey(after, b->key);
+			if (a == after.end()) fn(b, EntryPtr());
+			else if (*a != b) fn(b, *a);
+		}
+
+		for (auto& a : after)
+		{
+			if (findKey(before, a->key) == before.end()) fn(EntryPtr(), a);
+		}
+	}
+
+	template <typename Fn>
+	static size_t diffBranches(const Branch* from, const Branch* to, unsigned shift, Fn& fn)
+	{
+		if (from == to) return 0;
+
+		if (!from || !to || shift >= hashBits)
+		{
+			std::vector<EntryPtr> before, after;
+			collect(from, before);
+			collect(to, after);
+			diffEntries(before, after, fn);
+			return subtreeBytes(to);
+		}
+
+		auto result = branchBytes(*to);
+		for (auto bits = from->bitmap | to->bitmap; bits; bits &= bits - 1)
+		{
+			auto bit = bits & (~bits + 1);
+			auto a = (from->bitmap & bit) ? &from->slots[popcount(from->bitmap & (bit - 1))] : nullptr;
+			auto b = (to->bitmap & bit) ? &to->slots[popcount(to->bitmap & (bit - 1))] : nullptr;
+
+			if (a && b && a->branch && b->branch)
+			{
+				result += diffBranches(a->branch.get(), b->branch.get(), shift + bitsPerLevel, fn);
+			}
+			else if (a && b && a->entry == b->entry)
+			{
+				continue;
+			}
+			else
+			{
+				std::vector<EntryPtr> before, after;
+				collect(a, before);
+				collect(b, after);
+				diffEntries(before, after, fn);
+				if (b) result += subtreeBytes(b->branch.get());
+			}
+		}
+
+		return result;
+	}
+
+	void put(const EntryPtr& e)
+	{
+		bool added = false;
+		root_ = assoc(root_, 0, Hash()(e->key), e, added, true);
+		if (added) size_++;
+	}
+
+	void remove(const Key& key)
+	{
+		bool removed = false;
+		root_ = dissoc(root_, 0, Hash()(key), key, removed, true);
+		if (removed) size_--;
+	}
+
+	// Inserts key into the child list of parent, and returns the label it got there. Siblings that got a new label to
+	// make room for it are updated as well.
+	label_t insertChild(const Key& parent, size_t index, const Key& key)
+	{
+		auto slot = lookup(parent);
+		assert(slot);
+
+		auto e = makePooled<Entry>(**slot);
+		auto label = e->children.insert(index, key, [&](const Key& sibling, label_t siblingLabel) { setLabel(sibling, siblingLabel); });
+		put(e);
+		return label;
+	}
+
+	void setLabel(const Key& key, label_t label)
+	{
+		auto slot = lookup(key);
+		assert(slot);
+
+		auto e = makePooled<Entry>(**slot);
+		e->label = label;
+		put(e);
+	}
+
+	void setParent(const Key& key, const Key& parent, label_t label)
+	{
+		auto slot = lookup(key);
+		assert(slot);
+
+		auto e = makePooled<Entry>(**slot);
+		e->parent = parent;
+		e->hasParent = true;
+		e->label = label;
+		put(e);
+	}
+
+	// Removes key from the child list of its parent, leaving the entry itself in place
+	void detach(const Key& key)
+	{
+		auto e = entry(key);
+		assert(e);
+
+		if (!e->hasParent)
+		{
+			hasHead_ = false;
+			return;
+		}
+
+		auto slot = lookup(e->parent);
+		assert(slot);
+
+		auto parent = makePooled<Entry>(**slot);
+		parent->children.erase(parent->children.indexOf(e->label));
+		put(parent);
+	}
+
+	void removeSubtree(const Key& key)
+	{
+		auto e = entry(key);
+		assert(e);
+
+		auto children = e->children;
+		for (auto& child : children) removeSubtree(child);
+
+		remove(key);
+	}
+
+	BranchPtr root_;
+	size_t size_ {};
+	Key head_ {};
+	bool hasHead_ {};
+};
+
+// A persistent hash map with the same sharing as PersistentTree. It is stored as a tree whose entries have neither
+// children nor a head to hang off, so only the trie of the tree is used.
+template <typename Key, typename T, typename Hash = std::hash<Key>>
+class PersistentMap
+{
+public:
+	size_t size() const noexcept { return tree_.size(); }
+	bool empty() const noexcept { return tree_.empty(); }
+
+	const T* find(const Key& key) const noexcept { return tree_.find(key); }
+
+	void set(const Key& key, T value)
+	{
+		tree_.setEntry(makePooled<typename tree_t::Entry>(typename tree_t::Entry { key, std::move(value), Key(), true, {} }));
+	}
+
+	void erase(const Key& key)
+	{
+		if (tree_.entry(key)) tree_.removeEntry(key);
+	}
+
+private:
+	using tree_t = PersistentTree<Key, T, Hash>;
+	tree_t tree_;
+};
+
+END_NAMESPACE(Core)
@@ -0,0 +1,176 @@
+#include "pool.h"
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+using Core::Pool;
+
+namespace
+{
+	const size_t granularity = alignof(std::max_align_t) > 16 ? alignof(std::max_align_t) : 16;
+	const size_t classCount = Pool::maxBlockSize / granularity;
+	const size_t chunkSize = 64 * 1024;
+
+	// Blocks move between a thread cache and the shared free list in batches of this many
+	const size_t batchSize = 32;
+
+	struct Block
+	{
+		Block* next;
+	};
+
+	struct SizeClass
+	{
+		std::mutex mutex;
+		Block* free {};
+		std::vector<std::unique_ptr<char[]>> chunks;
+	};
+
+	// Never destroyed, so objects that are released during static destruction can still go back to their pool
+	SizeClass* sizeClasses()
+	{
+		static auto classes = new SizeClass[classCount];
+		return classes;
+	}
+
+	size_t sizeClassOf(size_t size)
+	{
+		return (std::max<size_t>(size, 1) - 1) / granularity;
+	}
+
+	// Takes count blocks off the shared free list, carving a new chunk first if there are not enough
+	Block* takeBlocks(size_t index, size_t count)
+	{
+		auto& sizeClass = sizeClasses()[index];
+		std::lock_guard<std::mutex> lock(sizeClass.mutex);
+
+		Block* head = nullptr;
+		for (size_t i = 0; i < count; i++)
+		{
+			if (!sizeClass.free)
+			{
+				auto blockSize = (index + 1) * granularity;
+				sizeClass.chunks.emplace_back(new char[chunkSize]);
+				auto chunk = sizeClass.chunks.back().get();
+				for (size_t offset = 0; offset + blockSize <= chunkSize; offset += blockSize)
+				{
+					auto block = reinterpret_cast<Block*>(chunk + offset);
+					block->next = sizeClass.free;
+					sizeClass.free = block;
+				}
+			}
+
+			auto block = sizeClass.free;
+			sizeClass.free = block->next;
+			block->next = head;
+			head = block;
+		}
+		return head;
+	}
+
+	void returnBlocks(size_t index, Block* head, Block* tail)
+	{
+		auto& sizeClass = sizeClasses()[index];
+		std::lock_guard<std::mutex> lock(sizeClass.mutex);
+		tail->next = sizeClass.free;
+		sizeClass.free = head;
+	}
+
+	struct ThreadCache
+	{
+		struct List
+		{
+			Block* head {};
+			size_t count {};
+		};
+
+		~ThreadCache();
+		List lists[classCount];
+	};
+
+	// Set once the cache of this thread is gone, after which blocks go straight to the shared free lists
+	thread_local bool threadCacheDestroyed = false;
+
+	ThreadCache::~ThreadCache()
+	{
+		for (size_t i = 0; i < classCount; i++)
+		{
+			auto head = lists[i].head;
+			if (!head) continue;
+
+			auto tail = head;
+			while (tail->next) tail = tail->next;
+			returnBlocks(i, head, tail);
+		}
+		threadCacheDestroyed = true;
+	}
+
+	ThreadCache& threadCache()
+	{
+		thread_local ThreadCache cache;
+		return cache;
+	}
+}
+
+void* Pool::allocate(size_t size)
+{
+	if (size > maxBlockSize) return ::operator new(size);
+
+	auto index = sizeClassOf(size);
+	if (threadCacheDestroyed) return takeBlocks(index, 1);
+
+	auto& list = threadCache().lists[index];
+	if (!list.head)
+	{
+		list.head = takeBlocks(index, batchSize);
+		list.count = batchSize;
+	}
+
+	auto block = list.head;
+	list.head = block->next;
+	list.count--;
+	return block;
+}
+
+void Pool::deallocate(void* ptr, size_t size) noexcept
+{
+	if (!ptr) return;
+	if (size > maxBlockSize) return ::operator delete(ptr);
+
+	auto index = sizeClassOf(size);
+	auto block = static_cast<Block*>(ptr);
+	if (threadCacheDestroyed)
+	{
+		returnBlocks(index, block, block);
+		return;
+	}
+
+	auto& list = threadCache().lists[index];
+	block->next = list.head;
+	list.head = block;
+	list.count++;
+
+	// Hand a batch back once a thread frees much more than it allocates, so other threads can reuse them
+	if (list.count >= 2 * batchSize)
+	{
+		auto tail = list.head;
+		for (size_t i = 1; i < batchSize; i++) tail = tail->next;
+		auto head = list.head;
+		list.head = tail->next;
+		list.count -= batchSize;
+		returnBlocks(index, head, tail);
+	}
+}
+
+size_t Pool::reservedBytes() noexcept
+{
+	size_t result = 0;
+	for (size_t i = 0; i < classCount; i++)
+	{
+		auto& sizeClass = sizeClasses()[i];
+		std::lock_guard<std::mutex> lock(sizeClass.mutex);
+		result += sizeClass.chunks.size() * chunkSize;
+	}
+	return result;
+}
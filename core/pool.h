@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+
+// Included from static.h ahead of the containers that use it, so this header cannot depend on static.h itself
+namespace Core {
+
+// Fixed size blocks for the small objects documents are made of. Blocks are carved out of larger chunks per size
+// class and recycled through a free list, with a small cache per thread so most allocations take no lock at all.
+// Chunks are never handed back, a freed block is simply reused by the next object of the same size class.
+class Pool
+{
+public:
+	static const size_t maxBlockSize = 512;
+
+	// Sizes above maxBlockSize go to the global operator new
+	static void* allocate(size_t size);
+	static void deallocate(void* ptr, size_t size) noexcept;
+
+	// Bytes held in chunks, whether the blocks in them are in use or not
+	static size_t reservedBytes() noexcept;
+};
+
+// Routes new and delete of a class to the pool, for pimpls that are created and destroyed with every mutation
+struct PoolAllocated
+{
+	static void* operator new(size_t size) { return Pool::allocate(size); }
+	static void operator delete(void* ptr, size_t size) noexcept { Pool::deallocate(ptr, size); }
+};
+
+template <typename T>
+struct PoolAllocator
+{
+	using value_type = T;
+
+	PoolAllocator() noexcept = default;
+	template <typename U> PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+	T* allocate(size_t n)
+	{
+		static_assert(alignof(T) <= alignof(std::max_align_t), "Pool blocks are only aligned for fundamental types");
+		return static_cast<T*>(Pool::allocate(n * sizeof(T)));
+	}
+
+	void deallocate(T* ptr, size_t n) noexcept { Pool::deallocate(ptr, n * sizeof(T)); }
+
+	template <typename U> bool operator==(const PoolAllocator<U>&) const noexcept { return true; }
+	template <typename U> bool operator!=(const PoolAllocator<U>&) const noexcept { return false; }
+};
+
+// make_shared for pooled objects: the object and its reference counts share a single pool block
+template <typename T, typename... Args>
+std::shared_ptr<T> makePooled(Args&&... args)
+{
+	return std::allocate_shared<T>(PoolAllocator<T>(), std::forward<Args>(args)...);
+}
+
+}
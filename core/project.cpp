@@ -5,11 +5,13 @@ using Core::Document;
 using Core::MutationInfo;
 using Core::NodePtr;
 using Core::Project;
+using Core::makePooled;
 
 Project::Project()
-	: root_(std::make_shared<Node>(HashValue()))
+	: root_(makePooled<Node>(HashValue()))
 {
-	history_.push_back({ "New project", { Document::buildRootDocument(root_) } });
+	current_ = Document::buildRootDocument(root_);
+	history_.push_back({ "New project", {}, std::make_shared<const Document>(current_), 0 });
 }
 
 void Project::undo() noexcept
@@ -17,8 +19,9 @@ void Project::undo() noexcept
 	assert(history_.size() > 1);
 
 	auto prevCurrent = current();
-	redoStack_.push(history_.back());
+	redoStack_.push(std::move(history_.back()));
 	history_.pop_back();
+	current_ = restore(history_.size() - 1);
 	
 	if (mutationCallback_) mutationCallback_(std::make_shared<MutationInfo>(prevCurrent, current()));
 }
@@ -28,7 +31,9 @@ void Project::redo() noexcept
 	assert(!redoStack_.empty());
 
 	auto prevCurrent = current();
-	history_.push_back(redoStack_.top());
+	auto& step = redoStack_.top();
+	current_ = step.snapshot ? *step.snapshot : current_.apply(step.delta);
+	history_.push_back(std::move(step));
 	redoStack_.pop();
 
 	if (mutationCallback_) mutationCallback_(std::make_shared<MutationInfo>(prevCurrent, current()));
@@ -40,8 +45,8 @@ Project::UndoState Project::undoState() const noexcept
 	auto canRedo = !redoStack_.empty();
 
 	return {
-		canUndo ? history_.at(history_.size() - 1).first : "",
-		canRedo ? redoStack_.top().first : "",
+		canUndo ? history_.back().description : "",
+		canRedo ? redoStack_.top().description : "",
 		canUndo,
 		canRedo
 	};
@@ -49,8 +54,7 @@ Project::UndoState Project::undoState() const noexcept
 
 const Document& Project::current() const noexcept
 {
-	assert(history_.size());
-	return history_.back().second;
+	return current_;
 }
 
 void Project::mutate(mutate_fn fn, std::string description) noexcept
@@ -61,25 +65,31 @@ void Project::mutate(mutate_fn fn, std::string description) noexcept
 void Project::mutate(std::initializer_list<mutate_fn> fns, std::string description) noexcept
 {
 	// When creating a new mutation, any redo actions that were still on the stack should be removed
-	while (!redoStack_.empty()) redoStack_.pop();
+	while (!redoStack_.empty())
+	{
+		historyBytes_ -= redoStack_.top().bytes;
+		redoStack_.pop();
+	}
 
 	auto originalState = current();
+	Document::journal_t journal;
 
-	bool needToReplace = false;
+	// Later functions can look up the nodes that earlier functions created
 	for (auto&& fn : fns)
 	{
 		auto b = Document::Builder(current());
 		fn(b);
 		b.fixupConnections();
-
-		if (needToReplace) history_.pop_back();
-		history_.push_back({ description, std::move(b) });
-		needToReplace = true;
+		journal.insert(end(journal), cbegin(b.journal()), cend(b.journal()));
+		current_ = std::move(b);
 	}
 
+	pushHistory(description, originalState);
+	trimHistory();
+
 	if (mutationCallback_)
 	{
-		mutationCallback_(std::make_shared<MutationInfo>(originalState, current()));
+		mutationCallback_(std::make_shared<MutationInfo>(originalState, current(), journal));
 	}
 }
 
@@ -93,6 +103,82 @@ void Project::emitMutationsComparedTo(const Document& d) const noexcept
 	mutationCallback_(std::make_shared<MutationInfo>(d, current()));
 }
 
+void Project::setHistorySettings(const HistorySettings& settings) noexcept
+{
+	historySettings_ = settings;
+	trimHistory();
+}
+
+size_t Project::historyBytes() const noexcept
+{
+	return historyBytes_;
+}
+
+void Project::pushHistory(std::string description, const Document& prev) noexcept
+{
+	HistoryStep step { std::move(description), {}, nullptr, 0 };
+
+	// Counting from the previous snapshot rather than from the first step, since trimming drops steps at the front
+	auto previous = find_if(history_.rbegin(), history_.rend(), [](auto& s) { return s.snapshot != nullptr; });
+	assert(previous != history_.rend());
+	auto sinceSnapshot = static_cast<size_t>(std::distance(history_.rbegin(), previous)) + 1;
+
+	auto interval = std::max<size_t>(1, historySettings_.snapshotInterval);
+	if (historySettings_.mode == HistoryMode::Snapshots || sinceSnapshot >= interval)
+	{
+		// A snapshot holds on to everything that changed since the previous snapshot
+		auto delta = current_.deltaFrom(*previous->snapshot);
+		step.snapshot = std::make_shared<const Document>(current_);
+		step.bytes = delta.bytes() + delta.treeBytes;
+	}
+	else
+	{
+		step.delta = current_.deltaFrom(prev);
+		step.bytes = step.delta.bytes();
+	}
+
+	step.bytes += sizeof(HistoryStep) + step.description.capacity();
+	historyBytes_ += step.bytes;
+	history_.push_back(std::move(step));
+}
+
+Document Project::restore(size_t step) const noexcept
+{
+	assert(step < history_.size());
+
+	auto first = step;
+	while (!history_[first].snapshot)
+	{
+		assert(first > 0); // the oldest step always has a snapshot
+		first--;
+	}
+
+	auto d = *history_[first].snapshot;
+	for (auto i = first + 1; i <= step; i++) d = d.apply(history_[i].delta);
+	return d;
+}
+
+void Project::trimHistory() noexcept
+{
+	if (!historySettings_.memoryBudget) return;
+
+	while (history_.size() > 1 && historyBytes_ > historySettings_.memoryBudget)
+	{
+		// The next step becomes the oldest one, so it needs to be restorable by itself
+		auto& next = history_[1];
+		if (!next.snapshot)
+		{
+			next.snapshot = std::make_shared<const Document>(restore(1));
+			next.delta = Document::Delta();
+		}
+
+		// Like the first document of a project, the oldest step is not counted as history
+		historyBytes_ -= history_.front().bytes + next.bytes;
+		next.bytes = 0;
+		history_.erase(begin(history_));
+	}
+}
+
 ///
 
 template<class Archive>
@@ -111,8 +197,15 @@ void Project::load(Archive& archive)
 
 	Document d;
 	archive(d);
-	history_ = { { "New project", { d } } };
+	current_ = d;
+
+	history_.clear();
+	while (!redoStack_.empty()) redoStack_.pop();
+	history_.push_back({ "New project", {}, std::make_shared<const Document>(current_), 0 });
+	historyBytes_ = 0;
 }
 
 template void Project::save<cereal::JSONOutputArchive>(cereal::JSONOutputArchive& archive) const;
 template void Project::load<cereal::JSONInputArchive>(cereal::JSONInputArchive& archive);
+template void Project::save<cereal::PortableBinaryOutputArchive>(cereal::PortableBinaryOutputArchive& archive) const;
+template void Project::load<cereal::PortableBinaryInputArchive>(cereal::PortableBinaryInputArchive& archive);
@@ -23,9 +23,29 @@ public:
 		}
 	};
 
-	using history_group_t = std::pair<std::string, Document>; // description + changes
-	using history_t = std::vector<history_group_t>;
-	using redohistory_t = std::stack<history_group_t>;
+	enum class HistoryMode
+	{
+		Snapshots, // keep a full document per undo step
+		Deltas // keep only the changes per undo step, plus a full document every snapshotInterval steps
+	};
+
+	struct HistorySettings
+	{
+		HistoryMode mode = HistoryMode::Snapshots;
+		size_t snapshotInterval = 32;
+		size_t memoryBudget = 0; // in bytes, 0 means unlimited. The oldest undo steps are dropped to stay within budget.
+	};
+
+	struct HistoryStep
+	{
+		std::string description;
+		Document::Delta delta; // compared to the previous step
+		std::shared_ptr<const Document> snapshot; // when set, the delta is not needed to restore this step
+		size_t bytes;
+	};
+
+	using history_t = std::vector<HistoryStep>;
+	using redohistory_t = std::stack<HistoryStep>;
 	using mutate_fn = std::function<void(Document::Builder&)>;
 	using mutation_callback_fn = std::function<void(std::shared_ptr<MutationInfo>)>;
 
@@ -44,13 +64,27 @@ public:
 	void setMutationCallback(mutation_callback_fn fn) noexcept;
 	void emitMutationsComparedTo(const Document& d) const noexcept;
 
-private:	
+	const HistorySettings& historySettings() const noexcept { return historySettings_; }
+	const history_t& history() const noexcept { return history_; }
+	void setHistorySettings(const HistorySettings& settings) noexcept;
+
+	// Estimate of the memory held by the undo and redo history, on top of the oldest document that can be restored
+	size_t historyBytes() const noexcept;
+
+private:
+	void pushHistory(std::string description, const Document& prev) noexcept;
+	Document restore(size_t step) const noexcept;
+	void trimHistory() noexcept;
+
 	friend class cereal::access;
 	template<class Archive> void save(Archive& archive) const;
 	template<class Archive>	void load(Archive& archive);
 
+	Document current_;
 	history_t history_;
 	redohistory_t redoStack_;
+	HistorySettings historySettings_;
+	size_t historyBytes_ {};
 	NodePtr root_;
 	mutation_callback_fn mutationCallback_;
 };
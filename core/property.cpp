@@ -1,9 +1,20 @@
 #include "property.h"
 #include "metadata.h"
 #include "factory.h"
+#include "cubic_kernel.h"
+#include "intern_table.h"
 
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+
+using Core::CubicKernel;
 using Core::Property;
 using Core::PropertyMetadata;
+using Core::PoolAllocated;
+using Core::InternTable;
+using Core::makePooled;
 using Core::Factory;
 using Core::Frame;
 using Core::HashValue;
@@ -12,13 +23,257 @@ using Core::PropertyMetadataPtr;
 using Core::PropertyValue;
 using Builder = Property::Builder;
 
-struct Property::Impl
+// Interpolation of ints is done in float, every other type is interpolated in itself
+template <typename T> struct Coefficient { using type = T; };
+template <> struct Coefficient<int> { using type = float; };
+
+// The polynomial a0 * t^3 + a1 * t^2 + a2 * t + a3 describing one segment of a spline
+template <typename T>
+using coefficients_t = std::array<typename Coefficient<T>::type, 4>;
+
+// Cubic spline through p and n, with pp and nn as the outer control points
+template <typename T>
+static coefficients_t<T> cubicCoefficients(const T& p_, const T& n_, const T& pp_, const T& nn_) noexcept
+{
+	using C = typename Coefficient<T>::type;
+	auto p = static_cast<C>(p_), n = static_cast<C>(n_), pp = static_cast<C>(pp_), nn = static_cast<C>(nn_);
+
+	return
+	{{
+		(pp * -0.5f) + (p * 1.5f) - (n * 1.5f) + (nn * 0.5f),
+		pp - p * 2.5f + n * 2.0f - nn * 0.5f,
+		pp * -0.5f + n * 0.5f,
+		p
+	}};
+}
+
+template <typename T>
+static T evaluateCubic(const coefficients_t<T>& a, float alpha) noexcept
+{
+	return static_cast<T>(((a[0] * alpha + a[1]) * alpha + a[2]) * alpha + a[3]);
+}
+
+// The spline coefficients of every pair of neighbouring keys. They only depend on the keys, so they are computed on
+// first use and kept until the keys change. Concurrent readers may compute them at the same time, but only the first
+// result is published, so references to it stay valid for as long as the keys don't change. Reading them back is a
+// single atomic load.
+template <typename T>
+class SegmentCache
+{
+public:
+	using segments_t = std::vector<coefficients_t<T>>;
+
+	SegmentCache() = default;
+	~SegmentCache() { reset(); }
+
+	// Copies are usually made to change the keys, so they start out empty
+	SegmentCache(const SegmentCache& rhs) noexcept {}
+
+	SegmentCache& operator=(const SegmentCache& rhs) noexcept
+	{
+		reset();
+		return *this;
+	}
+
+	void reset() noexcept
+	{
+		delete segments_.exchange(nullptr);
+	}
+
+	const segments_t& get(const std::vector<T>& values) const noexcept
+	{
+		auto segments = segments_.load(std::memory_order_acquire);
+		if (!segments)
+		{
+			auto computed = new segments_t();
+			computed->reserve(values.size());
+
+			// The outer control points are the keys of the segment itself
+			for (size_t i = 0; i + 1 < values.size(); i++) computed->push_back(cubicCoefficients(values[i], values[i + 1], values[i + 1], values[i]));
+
+			const segments_t* published = nullptr;
+			if (segments_.compare_exchange_strong(published, computed, std::memory_order_acq_rel)) segments = computed;
+			else
+			{
+				delete computed;
+				segments = published;
+			}
+		}
+		return *segments;
+	}
+
+private:
+	mutable std::atomic<const segments_t*> segments_ { nullptr };
+};
+
+// The values of the keys of a property, stored as the type of the property itself
+template <typename T>
+struct TypedKeys
+{
+	using value_type = T;
+
+	std::vector<T> values;
+	SegmentCache<T> segments;
+
+	T interpolate(size_t segment, float alpha) const noexcept
+	{
+		return evaluateCubic<T>(segments.get(values)[segment], alpha);
+	}
+};
+
+template <>
+inline std::string TypedKeys<std::string>::interpolate(size_t segment, float alpha) const noexcept
+{
+	return values[segment];
+}
+
+using channel_t = eggs::variant<TypedKeys<int>, TypedKeys<double>, TypedKeys<glm::vec2>, TypedKeys<glm::vec3>, TypedKeys<std::string>>;
+
+// Everything about a property apart from its identity. It never changes once a property has been built, and
+// structurally identical data is interned, so the many unanimated properties of a large scene share a few instances.
+struct PropertyData
 {
 	HashValue nodeType_;
 	HashValue propertyType_;
 	PropertyMetadataPtr metadata_;
-	keys_t keys_;
 	bool animated_ {};
+
+	// Keys are stored as two parallel arrays sorted by frame, so searching only touches the frames. The values are
+	// kept in a channel of the type of the property, picked from its default value when the metadata is set.
+	Property::keys_t frames_;
+	channel_t channel_;
+
+	// Index of the first key after frame. The loop only depends on the number of keys, and the comparison compiles
+	// to a conditional move, so the search does not suffer from mispredicted branches.
+	size_t upperBound(Frame frame) const noexcept
+	{
+		if (frames_.empty()) return 0;
+
+		auto base = frames_.data();
+		auto count = frames_.size();
+		while (count > 1)
+		{
+			auto half = count / 2;
+			base = base[half] <= frame ? base + half : base;
+			count -= half;
+		}
+		return (base - frames_.data()) + (*base <= frame);
+	}
+
+	template <typename T>
+	const TypedKeys<T>& keys() const noexcept
+	{
+		auto keys = channel_.target<TypedKeys<T>>();
+		assert(keys);
+		return *keys;
+	}
+
+	template <typename T>
+	T sample(const TypedKeys<T>& keys, Frame frame) const noexcept
+	{
+		if (frames_.empty()) return *metadata_->defaultValue().target<T>();
+
+		auto next = upperBound(frame);
+
+		// Beyond last item
+		if (next == frames_.size()) return keys.values.back();
+
+		// Before first
+		if (next == 0) return keys.values.front();
+
+		auto prev = next - 1;
+		if (frames_[prev] == frame) return keys.values[prev];
+
+		auto alpha = (static_cast<float>(frame) - static_cast<float>(frames_[prev])) / (static_cast<float>(frames_[next]) - static_cast<float>(frames_[prev]));
+		return keys.interpolate(prev, alpha);
+	}
+
+	PropertyValue value(size_t index) const noexcept
+	{
+		return eggs::variants::apply<PropertyValue>([&](const auto& keys) { return PropertyValue(keys.values[index]); }, channel_);
+	}
+
+	friend bool operator==(const PropertyData& lhs, const PropertyData& rhs) noexcept
+	{
+		if (lhs.nodeType_ != rhs.nodeType_ || lhs.propertyType_ != rhs.propertyType_ || lhs.metadata_ != rhs.metadata_) return false;
+		if (lhs.animated_ != rhs.animated_ || lhs.frames_ != rhs.frames_ || lhs.channel_.which() != rhs.channel_.which()) return false;
+
+		return eggs::variants::apply<bool>([&](const auto& keys)
+		{
+			return keys.values == rhs.channel_.template target<std::decay_t<decltype(keys)>>()->values;
+		}, lhs.channel_);
+	}
+};
+
+static size_t valueHash(int value) noexcept { return std::hash<int>()(value); }
+static size_t valueHash(double value) noexcept { return std::hash<double>()(value); }
+static size_t valueHash(const glm::vec2& value) noexcept { return std::hash<float>()(value.x) * 31 + std::hash<float>()(value.y); }
+static size_t valueHash(const glm::vec3& value) noexcept { return valueHash(glm::vec2(value.x, value.y)) * 31 + std::hash<float>()(value.z); }
+static size_t valueHash(const std::string& value) noexcept { return std::hash<std::string>()(value); }
+
+// Hashes the values as well as the frames, since properties of one type mostly share their frames
+struct property_data_hash
+{
+	size_t operator()(const PropertyData& data) const noexcept
+	{
+		auto h = std::hash<HashValue>()(data.nodeType_) * 31 + std::hash<HashValue>()(data.propertyType_);
+		for (auto frame : data.frames_) h = h * 31 + std::hash<Frame>()(frame);
+		return eggs::variants::apply<size_t>([&](const auto& keys)
+		{
+			for (auto&& value : keys.values) h = h * 31 + valueHash(value);
+			return h;
+		}, data.channel_);
+	}
+};
+
+// Never destroyed, so properties that are released during static destruction don't outlive it
+static InternTable<PropertyData, property_data_hash>& internTable()
+{
+	static auto table = new InternTable<PropertyData, property_data_hash>();
+	return *table;
+}
+
+static bool interning = true;
+
+struct Property::Impl: PoolAllocated
+{
+	Impl() = default;
+
+	// Copies share the data until one of them changes it. Data that a builder is still changing in place is not
+	// shared, since the builder would go on changing it in the copy as well.
+	Impl(const Impl& rhs) noexcept
+	{
+		*this = rhs;
+	}
+
+	Impl& operator=(const Impl& rhs) noexcept
+	{
+		changed_ = rhs.changed_ ? makePooled<PropertyData>(*rhs.changed_) : nullptr;
+		data_ = changed_ ? changed_ : rhs.data_;
+		return *this;
+	}
+
+	std::shared_ptr<const PropertyData> data_;
+
+	// Only set in builders, once they made a copy of the data of their own to change
+	std::shared_ptr<PropertyData> changed_;
+
+	PropertyData& mutableData() noexcept
+	{
+		if (!changed_)
+		{
+			changed_ = data_ ? makePooled<PropertyData>(*data_) : makePooled<PropertyData>();
+			data_ = changed_;
+		}
+		return *changed_;
+	}
+
+	// Called when a property gets built, after which its data no longer changes
+	void intern() noexcept
+	{
+		changed_.reset();
+		if (interning) data_ = internTable().intern(std::move(data_));
+	}
 };
 
 Property::Property()
@@ -46,124 +301,163 @@ Property& Property::operator=(const Property& rhs)
 Property::Property(Property&& rhs) = default;
 Property& Property::operator=(Property&& rhs) = default;
 
-struct Interpolator
+template <typename T>
+T Property::get(Frame frame) const noexcept
 {
-	explicit Interpolator(float alpha, PropertyValue& p, PropertyValue& n, PropertyValue& pp, PropertyValue& nn)
-		: alpha(alpha)
-		, p_(p)
-		, n_(n)
-		, pp_(pp)
-		, nn_(nn)
-	{}
+	auto& data = *impl_->data_;
+	return data.sample(data.keys<T>(), frame);
+}
 
-	float alpha;
-	PropertyValue& p_;
-	PropertyValue& n_;
-	PropertyValue& pp_;
-	PropertyValue& nn_;
+PropertyValue Property::getPropertyValue(Frame frame) const noexcept
+{
+	auto& data = *impl_->data_;
+	return eggs::variants::apply<PropertyValue>([&](const auto& keys) { return PropertyValue(data.sample(keys, frame)); }, data.channel_);
+}
 
-	template <typename T>
-	PropertyValue operator()(const T& _)
+// Evaluates a segment at many alphas. Doubles and float vectors go through the cubic kernel, one component at a time,
+// the other types are evaluated one value at a time.
+template <typename T>
+static void interpolateSegment(const TypedKeys<T>& keys, size_t segment, const float* alphas, size_t count, T* out) noexcept
+{
+	for (size_t i = 0; i < count; i++) out[i] = keys.interpolate(segment, alphas[i]);
+}
+
+template <typename T, int Components>
+static void interpolateComponents(const TypedKeys<T>& keys, size_t segment, const float* alphas, size_t count, T* out) noexcept
+{
+	auto& coefficients = keys.segments.get(keys.values)[segment];
+	for (int c = 0; c < Components; c++)
 	{
-		T& p = *p_.target<T>();
-		T& n = *n_.target<T>();
-		T& pp = *pp_.target<T>();
-		T& nn = *nn_.target<T>();
-
-		float alpha2 = alpha * alpha;
-		auto a0 = (pp * -0.5f) + (p * 1.5f) - (n * 1.5f) + (nn * 0.5f);
-		auto a1 = pp - p * 2.5f + n * 2.0f - nn * 0.5f;
-		auto a2 = pp * -0.5f + n * 0.5f;
-		auto a3 = p;
-
-		return static_cast<T>(a0 * alpha * alpha2 + a1 * alpha2 + a2 * alpha + a3);
+		float component[4] = { coefficients[0][c], coefficients[1][c], coefficients[2][c], coefficients[3][c] };
+		CubicKernel::evaluate(component, alphas, count, &out->x + c, Components);
 	}
-};
+}
 
 template <>
-inline PropertyValue Interpolator::operator()<std::string>(const std::string& _)
+void interpolateSegment<double>(const TypedKeys<double>& keys, size_t segment, const float* alphas, size_t count, double* out) noexcept
 {
-	return p_;
+	CubicKernel::evaluate(keys.segments.get(keys.values)[segment].data(), alphas, count, out);
 }
 
-PropertyValue Property::getPropertyValue(Frame frame) const noexcept
+template <>
+void interpolateSegment<glm::vec2>(const TypedKeys<glm::vec2>& keys, size_t segment, const float* alphas, size_t count, glm::vec2* out) noexcept
 {
-	if (!impl_->keys_.size()) return impl_->metadata_->defaultValue();
-
-	auto exactFrame = impl_->keys_.find(frame);
-	if (exactFrame != impl_->keys_.end()) return exactFrame->second;
+	interpolateComponents<glm::vec2, 2>(keys, segment, alphas, count, out);
+}
 
-	auto next = impl_->keys_.upper_bound(frame);
+template <>
+void interpolateSegment<glm::vec3>(const TypedKeys<glm::vec3>& keys, size_t segment, const float* alphas, size_t count, glm::vec3* out) noexcept
+{
+	interpolateComponents<glm::vec3, 3>(keys, segment, alphas, count, out);
+}
 
-	// Beyond last item
-	if (next == impl_->keys_.cend())
+template <typename T>
+void Property::sampleRange(Frame start, Frame step, size_t count, T* out) const noexcept
+{
+	auto& data = *impl_->data_;
+	auto& frames = data.frames_;
+	auto& keys = data.keys<T>();
+	if (frames.empty())
 	{
-		--next;
-		return next->second;
+		std::fill_n(out, count, *data.metadata_->defaultValue().target<T>());
+		return;
 	}
 
-	// Before first
-	if (next == impl_->keys_.cbegin())
+	// Search once, then move along with the frames, handing all frames that fall inside a segment over at once
+	std::array<float, 256> alphas;
+	auto next = data.upperBound(start);
+
+	for (size_t i = 0; i < count;)
 	{
-		return next->second;
-	}
+		auto frame = start + step * static_cast<Frame>(i);
+		while (next < frames.size() && frames[next] <= frame) next++;
+		while (next > 0 && frames[next - 1] > frame) next--;
 
-	auto prev = next--;
-	auto prevprev = prev--;
-	auto nextnext = next++;
+		if (next == frames.size() || next == 0 || frames[next - 1] == frame)
+		{
+			out[i++] = keys.values[next == 0 ? 0 : next - 1];
+			continue;
+		}
 
-	auto alpha = (static_cast<float>(frame) - static_cast<float>(prev->first)) / (static_cast<float>(next->first) - static_cast<float>(prev->first));
+		auto prev = next - 1;
+		auto from = static_cast<float>(frames[prev]);
+		auto to = static_cast<float>(frames[next]);
+
+		size_t run = 0;
+		for (; i + run < count && run < alphas.size(); run++)
+		{
+			auto f = start + step * static_cast<Frame>(i + run);
+			if (!(f > frames[prev] && f < frames[next])) break;
+			alphas[run] = (static_cast<float>(f) - from) / (to - from);
+		}
 
-	Interpolator interpolator(alpha, prev->second, next->second, prevprev->second, nextnext->second);
-	return eggs::variants::apply<PropertyValue>(interpolator, prev->second);
+		interpolateSegment(keys, prev, alphas.data(), run, out + i);
+		i += run;
+	}
 }
 
-std::set<Frame> Property::keys() const noexcept
+const Property::keys_t& Property::keys() const noexcept
 {
-	std::set<Frame> result;
-	for (auto&& kvp : impl_->keys_) result.insert(kvp.first);
-	return result;
+	return impl_->data_->frames_;
 }
 
 const PropertyMetadata& Property::metadata() const noexcept
 {
-	return *impl_->metadata_;
+	return *impl_->data_->metadata_;
 }
 
 bool Property::samePropertyHash(const PropertyPtr other) const noexcept
 {
-	return impl_->nodeType_ == other->impl_->nodeType_ && impl_->propertyType_ == other->impl_->propertyType_;
+	return impl_->data_->nodeType_ == other->impl_->data_->nodeType_ && impl_->data_->propertyType_ == other->impl_->data_->propertyType_;
 }
 
 bool Property::samePropertyHash(const HashValue otherNodeType, const HashValue otherPropertyType) const noexcept
 {
-	return impl_->nodeType_ == otherNodeType && impl_->propertyType_ == otherPropertyType;
+	return impl_->data_->nodeType_ == otherNodeType && impl_->data_->propertyType_ == otherPropertyType;
 }
 
-HashValue Property::nodeType() const noexcept { return impl_->nodeType_; }
-HashValue Property::propertyType() const noexcept { return impl_->propertyType_; }
+HashValue Property::nodeType() const noexcept { return impl_->data_->nodeType_; }
+HashValue Property::propertyType() const noexcept { return impl_->data_->propertyType_; }
 
 void Property::setMetadata(HashValue nodeType, HashValue propertyType, PropertyMetadataPtr metadata) noexcept
 {
-	impl_->nodeType_ = nodeType;
-	impl_->propertyType_ = propertyType;
+	auto& data = impl_->mutableData();
+	data.nodeType_ = nodeType;
+	data.propertyType_ = propertyType;
 	if (metadata)
 	{
-		impl_->metadata_ = metadata;
+		data.metadata_ = metadata;
 	}
 	else
 	{
 		auto nodeMetadata = Factory::metadata(nodeType);
 		if (nodeMetadata)
 		{
-			impl_->metadata_ = *find_if(begin(nodeMetadata->propertyMetadataCollection), end(nodeMetadata->propertyMetadataCollection), [&](auto& m) { return m->hash() == propertyType; });
+			data.metadata_ = *find_if(begin(nodeMetadata->propertyMetadataCollection), end(nodeMetadata->propertyMetadataCollection), [&](auto& m) { return m->hash() == propertyType; });
 		}
 	}
+
+	if (data.metadata_)
+	{
+		auto defaultValue = data.metadata_->defaultValue();
+		eggs::variants::apply<void>([&](const auto& value)
+		{
+			using T = std::decay_t<decltype(value)>;
+			if (!data.channel_.template target<TypedKeys<T>>()) data.channel_ = TypedKeys<T>();
+		}, defaultValue);
+	}
+
+	impl_->intern();
+}
+
+void Property::setInterning(bool enabled) noexcept
+{
+	interning = enabled;
 }
 
 PropertyValue Property::defaultValue() noexcept
 {
-	return impl_->metadata_->defaultValue();
+	return impl_->data_->metadata_->defaultValue();
 }
 
 /////////////////////////////////////////////////////////
@@ -192,27 +486,96 @@ Builder& Builder::operator=(Builder&& rhs) = default;
 
 Property::Property(Builder&& rhs)
 	: impl_(move(rhs.impl_))
-{}
+{
+	impl_->intern();
+}
 
 Property& Property::operator=(Builder&& rhs)
 {
 	impl_ = move(rhs.impl_);
+	impl_->intern();
 	return *this;
 }
 
+// Numbers convert between int and double, rounding to the nearest int
+template <typename T, typename From>
+static std::enable_if_t<std::is_arithmetic<T>::value && std::is_arithmetic<From>::value, bool> convertNumber(const From& from, T& to) noexcept
+{
+	to = static_cast<T>(std::is_integral<T>::value ? std::round(from) : from);
+	return true;
+}
+
+template <typename T, typename From>
+static std::enable_if_t<!std::is_arithmetic<T>::value || !std::is_arithmetic<From>::value, bool> convertNumber(const From&, T&) noexcept
+{
+	return false;
+}
+
+// Turns value into a T, and returns whether that was possible
+template <typename T>
+static bool convertValue(PropertyValue& value) noexcept
+{
+	if (value.target<T>()) return true;
+
+	T converted {};
+	if (!eggs::variants::apply<bool>([&](const auto& from) { return convertNumber(from, converted); }, value)) return false;
+	value = std::move(converted);
+	return true;
+}
+
 void Builder::set(Frame frame, PropertyValue value) noexcept
 {
-	impl_->keys_[frame] = value;
+	auto converted = eggs::variants::apply<bool>([&](const auto& keys)
+	{
+		return convertValue<typename std::decay_t<decltype(keys)>::value_type>(value);
+	}, impl_->data_->channel_);
+
+	if (!converted)
+	{
+		LOG->warn("Ignoring a key at frame {} that doesn't match the type of the property", frame);
+		return;
+	}
+
+	auto& data = impl_->mutableData();
+	auto& frames = data.frames_;
+	auto it = std::lower_bound(begin(frames), end(frames), frame);
+	auto index = std::distance(begin(frames), it);
+	auto exists = it != end(frames) && *it == frame;
+
+	eggs::variants::apply<void>([&](auto& keys)
+	{
+		using T = typename std::decay_t<decltype(keys)>::value_type;
+		auto typed = value.template target<T>();
+		assert(typed);
+
+		if (exists) keys.values[index] = std::move(*typed);
+		else keys.values.insert(begin(keys.values) + index, std::move(*typed));
+		keys.segments.reset();
+	}, data.channel_);
+
+	if (!exists) frames.insert(it, frame);
 }
 
 void Builder::erase(Frame frame) noexcept
 {
-	impl_->keys_.erase(frame);
+	auto& frames = impl_->data_->frames_;
+	auto it = std::lower_bound(begin(frames), end(frames), frame);
+	if (it == end(frames) || *it != frame) return;
+
+	// Only copy the data once it is sure to change
+	auto index = std::distance(begin(frames), it);
+	auto& data = impl_->mutableData();
+	eggs::variants::apply<void>([&](auto& keys)
+	{
+		keys.values.erase(begin(keys.values) + index);
+		keys.segments.reset();
+	}, data.channel_);
+	data.frames_.erase(begin(data.frames_) + index);
 }
 
 void Builder::setAnimated(bool animated) noexcept
 {
-	impl_->animated_ = animated;
+	impl_->mutableData().animated_ = animated;
 }
 
 ///
@@ -258,39 +621,59 @@ namespace cereal
 template<class Archive>
 void Property::save(Archive& archive) const
 {
-	archive(impl_->nodeType_);
-	archive(impl_->propertyType_);
+	auto& data = *impl_->data_;
+	archive(data.nodeType_);
+	archive(data.propertyType_);
 
-	archive(impl_->keys_.size());
-	for (auto&& kvp : impl_->keys_)
+	archive(data.frames_.size());
+	for (size_t i = 0; i < data.frames_.size(); i++)
 	{
-		archive(kvp.first);
-		archive(kvp.second);
+		archive(data.frames_[i]);
+		archive(data.value(i));
 	}
 
-	archive(impl_->animated_);
+	archive(data.animated_);
 }
 
 template<class Archive>
 void Property::load(Archive& archive)
 {
-	archive(impl_->nodeType_);
-	archive(impl_->propertyType_);
-	setMetadata(impl_->nodeType_, impl_->propertyType_);
+	HashValue nodeType, propertyType;
+	archive(nodeType);
+	archive(propertyType);
+	setMetadata(nodeType, propertyType);
 
 	size_t size;
 	archive(size);
+	Builder builder(*this);
 	for (size_t t = 0; t < size; t++)
 	{
 		Frame frame;
 		PropertyValue value = defaultValue();
 		archive(frame);
 		archive(value);
-		impl_->keys_[frame] = value;
+		builder.set(frame, std::move(value));
 	}
 
-	archive(impl_->animated_);
+	bool animated;
+	archive(animated);
+	builder.setAnimated(animated);
+	*this = std::move(builder);
 }
 
 template void Property::save<cereal::JSONOutputArchive>(cereal::JSONOutputArchive& archive) const;
 template void Property::load<cereal::JSONInputArchive>(cereal::JSONInputArchive& archive);
+template void Property::save<cereal::PortableBinaryOutputArchive>(cereal::PortableBinaryOutputArchive& archive) const;
+template void Property::load<cereal::PortableBinaryInputArchive>(cereal::PortableBinaryInputArchive& archive);
+
+template void Property::sampleRange<int>(Frame start, Frame step, size_t count, int* out) const noexcept;
+template void Property::sampleRange<double>(Frame start, Frame step, size_t count, double* out) const noexcept;
+template void Property::sampleRange<glm::vec2>(Frame start, Frame step, size_t count, glm::vec2* out) const noexcept;
+template void Property::sampleRange<glm::vec3>(Frame start, Frame step, size_t count, glm::vec3* out) const noexcept;
+template void Property::sampleRange<std::string>(Frame start, Frame step, size_t count, std::string* out) const noexcept;
+
+template int Property::get<int>(Frame frame) const noexcept;
+template double Property::get<double>(Frame frame) const noexcept;
+template glm::vec2 Property::get<glm::vec2>(Frame frame) const noexcept;
+template glm::vec3 Property::get<glm::vec3>(Frame frame) const noexcept;
+template std::string Property::get<std::string>(Frame frame) const noexcept;
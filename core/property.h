@@ -8,7 +8,7 @@ class PropertyMetadata;
 class Property
 {
 public:
-	using keys_t = std::map<Frame, PropertyValue>;
+	using keys_t = std::vector<Frame>;
 
 private:
 	struct Impl;
@@ -36,6 +36,7 @@ public:
 		Builder(Builder&& rhs);
 		Builder& operator=(Builder&& rhs);
 
+		// Numbers are converted to the type of the property, other values of another type are ignored
 		void set(Frame frame, PropertyValue value) noexcept;
 		void erase(Frame frame) noexcept;
 
@@ -49,14 +50,17 @@ public:
 	Property(Builder&& rhs);
 	Property& operator=(Builder&& rhs);
 
+	// Samples the property without going through PropertyValue. T has to be the type of the property.
 	template <typename T>
-	T get(Frame frame) const
-	{
-		return *getPropertyValue(frame).target<T>();
-	}
+	T get(Frame frame) const noexcept;
 
 	PropertyValue getPropertyValue(Frame frame) const noexcept;
-	std::set<Frame> keys() const noexcept;
+
+	// Samples count frames, step frames apart, from start on. T has to be the type of the property.
+	template <typename T>
+	void sampleRange(Frame start, Frame step, size_t count, T* out) const noexcept;
+
+	const keys_t& keys() const noexcept;
 
 	const PropertyMetadata& metadata() const noexcept;
 	bool samePropertyHash(const PropertyPtr other) const noexcept;
@@ -64,6 +68,10 @@ public:
 	HashValue nodeType() const noexcept;
 	HashValue propertyType() const noexcept;
 
+	// Properties with the same node type, property type and keys share their data. Turning that off is only meant for
+	// measuring what it saves.
+	static void setInterning(bool enabled) noexcept;
+
 	friend std::ostream& operator<<(std::ostream& out, const Property& p);
 	friend std::ostream& operator<<(std::ostream& out, Property* p) { out << *p; return out; }
 
@@ -0,0 +1,43 @@
+#include "sampler.h"
+
+using Core::Document;
+using Core::Frame;
+using Core::PropertyPtr;
+using Core::Sampler;
+
+struct Sampler::ChannelSampler
+{
+	explicit ChannelSampler(Sampler& sampler, const PropertyPtr& property)
+		: sampler(sampler)
+		, property(property)
+	{}
+
+	Sampler& sampler;
+	const PropertyPtr& property;
+
+	template <typename T>
+	void operator()(const T& _)
+	{
+		auto& channel = std::get<Channel<T>>(sampler.channels_);
+		auto offset = channel.values.size();
+		channel.values.resize(offset + sampler.count_);
+		channel.offsets[property.get()] = offset;
+		property->sampleRange(sampler.start_, sampler.step_, sampler.count_, channel.values.data() + offset);
+	}
+};
+
+Sampler::Sampler(const Document& document, Frame start, Frame step, size_t count)
+	: start_(start)
+	, step_(step)
+	, count_(count)
+{
+	for (auto&& node : document.nodes())
+	{
+		for (auto&& property : node->properties())
+		{
+			ChannelSampler sampler(*this, property);
+			auto defaultValue = property->metadata().defaultValue();
+			eggs::variants::apply(sampler, defaultValue);
+		}
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "static.h"
+#include "document.h"
+
+#include <tuple>
+
+BEGIN_NAMESPACE(Core)
+
+// Samples every property of every node in a document over a range of frames in one go. The samples of all
+// properties of the same type end up in one contiguous buffer, count values per property.
+class Sampler
+{
+public:
+	Sampler(const Document& document, Frame start, Frame step, size_t count);
+
+	Frame start() const noexcept { return start_; }
+	Frame step() const noexcept { return step_; }
+	size_t count() const noexcept { return count_; }
+
+	// The samples of property, or nullptr if it was not sampled as a T
+	template <typename T>
+	const T* samples(const Property& property) const noexcept
+	{
+		auto& channel = std::get<Channel<T>>(channels_);
+		auto it = channel.offsets.find(&property);
+		return it != end(channel.offsets) ? channel.values.data() + it->second : nullptr;
+	}
+
+private:
+	template <typename T>
+	struct Channel
+	{
+		std::vector<T> values;
+		std::unordered_map<const Property*, size_t> offsets;
+	};
+
+	struct ChannelSampler;
+
+	Frame start_;
+	Frame step_;
+	size_t count_;
+	std::tuple<Channel<int>, Channel<double>, Channel<glm::vec2>, Channel<glm::vec3>, Channel<std::string>> channels_;
+};
+
+END_NAMESPACE(Core)
@@ -0,0 +1,73 @@
+#include "scene_evaluator.h"
+
+using Core::Document;
+using Core::Frame;
+using Core::Node;
+using Core::SceneEvaluator;
+using Core::ThreadPool;
+
+struct SceneEvaluator::SlotSampler
+{
+	explicit SlotSampler(SceneEvaluator& evaluator, const Slot& slot)
+		: evaluator(evaluator)
+		, slot(slot)
+	{}
+
+	SceneEvaluator& evaluator;
+	const Slot& slot;
+
+	template <typename T>
+	void operator()(const T& _)
+	{
+		// The buffers were sized up front, so this only ever touches the values of this slot
+		auto* out = std::get<std::vector<T>>(evaluator.channels_).data() + slot.offset;
+		slot.property->sampleRange(evaluator.start_, evaluator.step_, evaluator.count_, out);
+	}
+};
+
+SceneEvaluator::SceneEvaluator(const Document& document, Frame start, Frame step, size_t count, ThreadPool& pool)
+	: start_(start)
+	, step_(step)
+	, count_(count)
+{
+	// Lay out all slots first, so the sampling below never has to grow a buffer
+	size_t sizes[std::tuple_size<decltype(channels_)>::value] {};
+	nodeOffsets_.push_back(0);
+
+	for (auto&& node : document.nodes())
+	{
+		nodeIndices_[node.get()] = nodeOffsets_.size() - 1;
+
+		for (auto&& property : node->properties())
+		{
+			auto type = property->metadata().defaultValue().which();
+			slots_.push_back({ property.get(), type, sizes[type] });
+			sizes[type] += count;
+		}
+
+		nodeOffsets_.push_back(slots_.size());
+	}
+
+	std::get<std::vector<int>>(channels_).resize(sizes[0]);
+	std::get<std::vector<double>>(channels_).resize(sizes[1]);
+	std::get<std::vector<glm::vec2>>(channels_).resize(sizes[2]);
+	std::get<std::vector<glm::vec3>>(channels_).resize(sizes[3]);
+	std::get<std::vector<std::string>>(channels_).resize(sizes[4]);
+
+	// A handful of properties per task keeps the scheduling overhead small next to the sampling itself
+	pool.parallelFor(slots_.size(), 16, [this](size_t begin, size_t end)
+	{
+		for (auto i = begin; i < end; i++)
+		{
+			SlotSampler sampler(*this, slots_[i]);
+			auto defaultValue = slots_[i].property->metadata().defaultValue();
+			eggs::variants::apply<void>(sampler, defaultValue);
+		}
+	});
+}
+
+size_t SceneEvaluator::nodeIndex(const Node& node) const noexcept
+{
+	auto it = nodeIndices_.find(&node);
+	return it != end(nodeIndices_) ? it->second : nodeCount();
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include "static.h"
+#include "document.h"
+#include "thread_pool.h"
+
+#include <tuple>
+
+BEGIN_NAMESPACE(Core)
+
+// Samples every property of every node in a document over a range of frames, spread over a thread pool. Nodes are
+// numbered in document order and properties in node order. All samples of one property are stored next to each other,
+// in one flat buffer per value type, so every task writes to its own part of the buffers.
+class SceneEvaluator
+{
+public:
+	SceneEvaluator(const Document& document, Frame start, Frame step, size_t count, ThreadPool& pool);
+
+	Frame start() const noexcept { return start_; }
+	Frame step() const noexcept { return step_; }
+	size_t count() const noexcept { return count_; }
+
+	size_t nodeCount() const noexcept { return nodeOffsets_.size() - 1; }
+	size_t propertyCount(size_t node) const noexcept { return nodeOffsets_[node + 1] - nodeOffsets_[node]; }
+
+	// Index of node in the results, or nodeCount() if the document does not contain it
+	size_t nodeIndex(const Node& node) const noexcept;
+
+	// The samples of a property of a node, or nullptr if that property is not a T
+	template <typename T>
+	const T* samples(size_t node, size_t property) const noexcept
+	{
+		auto& slot = slots_[nodeOffsets_[node] + property];
+		if (slot.type != PropertyValue(T()).which()) return nullptr;
+		return std::get<std::vector<T>>(channels_).data() + slot.offset;
+	}
+
+private:
+	struct Slot
+	{
+		const Property* property;
+		size_t type;
+		size_t offset;
+	};
+
+	struct SlotSampler;
+
+	Frame start_;
+	Frame step_;
+	size_t count_;
+
+	std::vector<size_t> nodeOffsets_;
+	std::unordered_map<const Node*, size_t> nodeIndices_;
+	std::vector<Slot> slots_;
+	std::tuple<std::vector<int>, std::vector<double>, std::vector<glm::vec2>, std::vector<glm::vec3>, std::vector<std::string>> channels_;
+};
+
+END_NAMESPACE(Core)
@@ -13,10 +13,10 @@
 #include <vector>
 #include <stack>
 #include <eggs/variant.hpp>
-#include <tree/tree.h>
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 #include <cereal/archives/json.hpp>
+#include <cereal/archives/portable_binary.hpp>
 #include <cereal/types/map.hpp>
 #include <cereal/types/utility.hpp>
 #include <cereal/types/unordered_set.hpp>
@@ -27,6 +27,8 @@
 #include "prettyprint.h"
 #include "stringhash.h"
 #include "uuid.h"
+#include "pool.h"
+#include "persistent_tree.h"
 #include "log.h"
 
 namespace cereal
@@ -65,7 +67,8 @@ namespace Core
 	class Project;
 	class Document;
 	struct MutationInfo;
+	struct Uuid;
 
-	using tree_t = tree<NodePtr>;
+	using tree_t = PersistentTree<Uuid, NodePtr>;
 	using visibility_t = std::pair<Frame, Frame>;
 };
\ No newline at end of file
@@ -0,0 +1,116 @@
+#include "thread_pool.h"
+
+using Core::ThreadPool;
+
+ThreadPool::ThreadPool(size_t threadCount)
+{
+	threadCount = std::max<size_t>(threadCount, 1);
+
+	for (size_t i = 0; i < threadCount; i++) queues_.emplace_back(std::make_unique<Queue>());
+	for (size_t i = 0; i < threadCount; i++) threads_.emplace_back([this, i] { work(i); });
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(wakeMutex_);
+		stopping_ = true;
+	}
+	wake_.notify_all();
+
+	for (auto& thread : threads_) thread.join();
+}
+
+void ThreadPool::parallelFor(size_t count, size_t grainSize, const range_fn& fn)
+{
+	if (!count) return;
+	grainSize = std::max<size_t>(grainSize, 1);
+
+	// Counts down the ranges, and wakes up the caller once the last one is done
+	struct Latch
+	{
+		std::mutex mutex;
+		std::condition_variable done;
+		size_t remaining;
+	} latch;
+	latch.remaining = (count + grainSize - 1) / grainSize;
+
+	size_t queue = 0;
+	for (size_t begin = 0; begin < count; begin += grainSize)
+	{
+		auto end = std::min(count, begin + grainSize);
+		push(queue++ % queues_.size(), [&fn, &latch, begin, end]
+		{
+			fn(begin, end);
+
+			// Notify under the lock, so the caller can't return and destroy the latch before this is done with it
+			std::lock_guard<std::mutex> lock(latch.mutex);
+			if (--latch.remaining == 0) latch.done.notify_all();
+		});
+	}
+
+	{
+		// Taking the lock makes sure no worker misses the wake up between checking for tasks and going to sleep
+		std::lock_guard<std::mutex> lock(wakeMutex_);
+	}
+	wake_.notify_all();
+
+	// Help out while there are tasks left to take, then sleep until the ones still running on other threads are done
+	while (runOne(0)) {}
+
+	std::unique_lock<std::mutex> lock(latch.mutex);
+	latch.done.wait(lock, [&] { return latch.remaining == 0; });
+}
+
+void ThreadPool::push(size_t queue, task_t task)
+{
+	std::lock_guard<std::mutex> lock(queues_[queue]->mutex);
+	queues_[queue]->tasks.emplace_back(std::move(task));
+	queued_++;
+}
+
+bool ThreadPool::runOne(size_t queue)
+{
+	task_t task;
+
+	// Newest task of our own queue first, as its data is most likely still in cache
+	{
+		auto& own = *queues_[queue];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.tasks.empty())
+		{
+			task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+		}
+	}
+
+	// Otherwise steal the oldest task of another queue
+	for (size_t i = 1; !task && i < queues_.size(); i++)
+	{
+		auto& other = *queues_[(queue + i) % queues_.size()];
+		std::lock_guard<std::mutex> lock(other.mutex);
+		if (!other.tasks.empty())
+		{
+			task = std::move(other.tasks.front());
+			other.tasks.pop_front();
+		}
+	}
+
+	if (!task) return false;
+
+	queued_--;
+	task();
+	return true;
+}
+
+void ThreadPool::work(size_t queue)
+{
+	for (;;)
+	{
+		if (runOne(queue)) continue;
+
+		std::unique_lock<std::mutex> lock(wakeMutex_);
+		wake_.wait(lock, [&] { return stopping_ || queued_ > 0; });
+		if (stopping_) return;
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "static.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+BEGIN_NAMESPACE(Core)
+
+// A fixed set of worker threads with a task queue each. Workers take tasks from the back of their own queue and steal
+// from the front of the others once theirs is empty, so uneven work evens out without a single contended queue.
+class ThreadPool
+{
+public:
+	using task_t = std::function<void()>;
+	using range_fn = std::function<void(size_t begin, size_t end)>;
+
+	explicit ThreadPool(size_t threadCount = std::thread::hardware_concurrency());
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	size_t threadCount() const noexcept { return threads_.size(); }
+
+	// Calls fn for consecutive ranges of at most grainSize items that together cover [0, count), and returns once all
+	// of them are done. The calling thread runs tasks as well while it waits.
+	void parallelFor(size_t count, size_t grainSize, const range_fn& fn);
+
+private:
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<task_t> tasks;
+	};
+
+	void push(size_t queue, task_t task);
+	bool runOne(size_t queue);
+	void work(size_t queue);
+
+	std::vector<std::unique_ptr<Queue>> queues_;
+	std::vector<std::thread> threads_;
+
+	std::mutex wakeMutex_;
+	std::condition_variable wake_;
+	std::atomic<size_t> queued_ { 0 };
+	bool stopping_ {};
+};
+
+END_NAMESPACE(Core)
@@ -151,5 +151,7 @@ namespace Core {
 
 	template void Uuid::serialize<cereal::JSONOutputArchive>(cereal::JSONOutputArchive& archive);
 	template void Uuid::serialize<cereal::JSONInputArchive>(cereal::JSONInputArchive& archive);
+	template void Uuid::serialize<cereal::PortableBinaryOutputArchive>(cereal::PortableBinaryOutputArchive& archive);
+	template void Uuid::serialize<cereal::PortableBinaryInputArchive>(cereal::PortableBinaryInputArchive& archive);
 
 } // ::Core
\ No newline at end of file
@@ -1,12 +1,15 @@
 #include "application.h"
 #include "actions.h"
+#include "device_stream.h"
 #include "modules/graph/module.h"
 #include "modules/inspector/module.h"
 #include "modules/timeline/module.h"
+#include <core/memory_stream.h>
 
 using Core::Project;
 using Editor::Actions;
 using Editor::Application;
+using Editor::DeviceStreamBuf;
 using Editor::Modules::ActionFlags;
 using Editor::Modules::Metadata;
 
@@ -170,7 +173,7 @@ void Application::setup()
 
 void Application::openFile()
 {
-	auto filename = QFileDialog::getOpenFileName(nullptr, tr("Open project"), QString(), tr("Project files (*.json)"));
+	auto filename = QFileDialog::getOpenFileName(nullptr, tr("Open project"), QString(), tr("Project files (*.pxs *.json)"));
 	if (!filename.isEmpty())
 	{
 		load(filename);
@@ -179,48 +182,109 @@ void Application::openFile()
 
 void Application::saveFileAs()
 {
-	auto filename = QFileDialog::getSaveFileName(nullptr, tr("Save project"), QString(), tr("Project files (*.json)"));
+	auto filename = QFileDialog::getSaveFileName(nullptr, tr("Save project"), QString(), tr("Binary project files (*.pxs);;JSON project files (*.json)"));
 	if (!filename.isEmpty())
 	{
 		save(filename);
 	}
 }
 
+// Projects are stored as portable binary unless the file name asks for JSON
+static bool isJsonFile(const QString& filename)
+{
+	return filename.endsWith(".json", Qt::CaseInsensitive);
+}
+
 void Application::load(QString filename)
 {
+	auto fail = [&](QString reason)
+	{
+		QMessageBox::warning(mainWindow_, tr("Open project"), tr("Could not open %1: %2").arg(QDir::toNativeSeparators(filename), reason));
+	};
+
 	QFile file(filename);
-	if (!file.open(QFile::ReadOnly)) return;
+	if (!file.open(QFile::ReadOnly))
+	{
+		fail(file.errorString());
+		return;
+	}
 
-	QString contents = file.readAll();
+	// Loaded on the side, so a file that turns out to be broken leaves the open project alone
+	Project loaded;
+	try
+	{
+		// Read straight from the mapped file if possible, and otherwise stream it in chunks
+		std::unique_ptr<std::streambuf> buffer;
+		auto data = file.size() > 0 ? file.map(0, file.size()) : nullptr;
+		if (data) buffer = std::make_unique<Core::MemoryStreamBuf>(reinterpret_cast<const char*>(data), file.size());
+		else buffer = std::make_unique<DeviceStreamBuf>(&file);
+
+		std::istream s(buffer.get());
+		if (isJsonFile(filename))
+		{
+			cereal::JSONInputArchive archive(s);
+			archive(loaded);
+		}
+		else
+		{
+			cereal::PortableBinaryInputArchive archive(s);
+			archive(loaded);
+		}
+	}
+	catch (const std::exception& e)
+	{
+		// Truncated or foreign files make the archives throw, or allocate whatever size they read
+		fail(file.error() != QFileDevice::NoError ? file.errorString() : QString::fromUtf8(e.what()));
+		return;
+	}
 
 	setup();
 	auto emptyDocument = project_.current();
 
-	{
-		std::stringstream s;
-		std::string strContents = contents.toStdString();
-		s << strContents;
-		cereal::JSONInputArchive archive(s);
-		archive(project_);
-	}
-
+	// The loaded project takes over the mutation callback that setup() gave the empty one
+	loaded.setMutationCallback([&](auto mutationInfo) { emit projectMutated(mutationInfo); });
+	project_ = std::move(loaded);
 	project_.emitMutationsComparedTo(emptyDocument);
 }
 
 void Application::save(QString filename)
 {
-	std::stringstream s;
+	auto fail = [&](QString reason)
 	{
-		cereal::JSONOutputArchive archive(s);
-		archive(project_);
-	}
+		QMessageBox::warning(mainWindow_, tr("Save project"), tr("Could not save %1: %2").arg(QDir::toNativeSeparators(filename), reason));
+	};
 
 	QFile file(filename);
-	if (file.open(QFile::WriteOnly | QFile::Truncate))
+	if (!file.open(QFile::WriteOnly | QFile::Truncate))
+	{
+		fail(file.errorString());
+		return;
+	}
+
+	DeviceStreamBuf buffer(&file);
+	std::ostream s(&buffer);
+	try
 	{
-		QTextStream stream(&file);
-		stream << s.str().c_str();
+		if (isJsonFile(filename))
+		{
+			cereal::JSONOutputArchive archive(s);
+			archive(project_);
+		}
+		else
+		{
+			cereal::PortableBinaryOutputArchive archive(s);
+			archive(project_);
+		}
 	}
+	catch (const cereal::Exception& e)
+	{
+		// The binary archive throws when the stream doesn't take all it writes
+		fail(file.error() != QFileDevice::NoError ? file.errorString() : QString::fromUtf8(e.what()));
+		return;
+	}
+
+	// The buffer only hands its last chunk to the file when synced, and the file has buffers of its own
+	if (!s || buffer.pubsync() != 0 || !file.flush() || file.error() != QFileDevice::NoError) fail(file.errorString());
 }
 
 bool Application::eventFilter(QObject* object, QEvent* event)
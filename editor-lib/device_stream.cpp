@@ -0,0 +1,45 @@
+#include "device_stream.h"
+
+using Editor::DeviceStreamBuf;
+
+DeviceStreamBuf::DeviceStreamBuf(QIODevice* device) noexcept
+	: device_(device)
+{
+	setp(buffer_.data(), buffer_.data() + buffer_.size());
+}
+
+DeviceStreamBuf::~DeviceStreamBuf()
+{
+	sync();
+}
+
+DeviceStreamBuf::int_type DeviceStreamBuf::overflow(int_type c)
+{
+	if (sync() != 0) return traits_type::eof();
+	if (traits_type::eq_int_type(c, traits_type::eof())) return traits_type::not_eof(c);
+
+	*pptr() = traits_type::to_char_type(c);
+	pbump(1);
+	return c;
+}
+
+int DeviceStreamBuf::sync()
+{
+	auto pending = pptr() - pbase();
+	if (pending == 0) return 0;
+
+	if (device_->write(pbase(), pending) != pending) return -1;
+	setp(buffer_.data(), buffer_.data() + buffer_.size());
+	return 0;
+}
+
+DeviceStreamBuf::int_type DeviceStreamBuf::underflow()
+{
+	if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+
+	auto read = device_->read(buffer_.data(), buffer_.size());
+	if (read <= 0) return traits_type::eof();
+
+	setg(buffer_.data(), buffer_.data(), buffer_.data() + read);
+	return traits_type::to_int_type(*gptr());
+}
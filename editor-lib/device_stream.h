@@ -0,0 +1,27 @@
+#pragma once
+#include "static.h"
+
+#include <array>
+#include <streambuf>
+
+BEGIN_NAMESPACE(Editor)
+
+// Lets standard streams (and so cereal archives) read from or write to a QIODevice in small chunks,
+// so a project never has to be held in memory as a whole while saving or loading it
+class DeviceStreamBuf: public std::streambuf
+{
+public:
+	explicit DeviceStreamBuf(QIODevice* device) noexcept;
+	~DeviceStreamBuf();
+
+protected:
+	int_type overflow(int_type c) override;
+	int sync() override;
+	int_type underflow() override;
+
+private:
+	QIODevice* device_;
+	std::array<char, 64 * 1024> buffer_;
+};
+
+END_NAMESPACE(Editor)
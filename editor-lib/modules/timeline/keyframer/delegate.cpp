@@ -60,28 +60,20 @@ QWidget* Delegate::createEditor(QWidget* parent, const QStyleOptionViewItem& opt
 
 void Delegate::resetSelection()
 {
-	for (auto&& widget : selected()) widget->setSelected(false);
+	// Deselecting removes the widget from selected_
+	auto selected = selected_;
+	for (auto&& widget : selected) widget->setSelected(false);
 }
 
 void Delegate::setSelected(Widget* widget, bool selected)
 {
-	auto s = this->selected();
-	if (selected)
-	{
-		if (s.find(widget) != end(s)) return;
-		widget->setSelected(true);
-	}
-	else
-	{
-		if (s.find(widget) == end(s)) return;
-		widget->setSelected(false);
-	}
+	if (isSelected(widget) == selected) return;
+	widget->setSelected(selected);
 }
 
 bool Delegate::isSelected(Widget* widget) const
 {
-	auto s = selected();
-	return s.find(widget) != end(s);
+	return selected_.find(widget) != end(selected_);
 }
 
 void Delegate::deleteSelected()
@@ -137,60 +129,113 @@ void Delegate::deleteSelected()
 
 void Delegate::setRubberBandSelection(QRect globalRect)
 {
-	for (auto&& widget : widgets())
-	{
-		auto globalNodeRect = QRect(0, 0, widget->width(), widget->height()).translated(widget->parentWidget()->mapToGlobal(widget->pos()));
+	if (!hasRubberBandIndex_) buildRubberBandIndex();
 
-		if (globalRect.intersects(globalNodeRect))
+	// Only the rows the band covers, and in those only the widgets it can reach, are visited
+	std::unordered_set<Widget*> inside;
+	auto row = std::partition_point(begin(rubberBandIndex_), end(rubberBandIndex_), [&](const RubberBandRow& r) { return r.bottom < globalRect.top(); });
+	for (; row != end(rubberBandIndex_) && row->top <= globalRect.bottom(); ++row)
+	{
+		auto widget = std::partition_point(begin(row->widgets), end(row->widgets), [&](const std::pair<QRect, Widget*>& w) { return w.first.left() + row->maxWidth < globalRect.left(); });
+		for (; widget != end(row->widgets) && widget->first.left() <= globalRect.right(); ++widget)
 		{
-			if (!isSelected(widget))
-			{
-				dragSelected_.insert(widget);
-				setSelected(widget, true);
-			}
+			if (globalRect.intersects(widget->first)) inside.insert(widget->second);
 		}
-		else
+	}
+
+	for (auto&& widget : inside)
+	{
+		if (isSelected(widget)) continue;
+		dragSelected_.insert(widget);
+		setSelected(widget, true);
+	}
+
+	for (auto it = begin(dragSelected_); it != end(dragSelected_);)
+	{
+		if (inside.find(*it) != end(inside))
 		{
-			if (dragSelected_.find(widget) != end(dragSelected_))
-			{
-				dragSelected_.erase(widget);
-				setSelected(widget, false);
-			}
+			++it;
+			continue;
 		}
+
+		auto widget = *it;
+		it = dragSelected_.erase(it);
+		setSelected(widget, false);
 	}
 }
 
-const std::unordered_set<Widget*> Delegate::widgets() const
+void Delegate::endRubberBandSelection()
 {
-	std::unordered_set<Widget*> result;
-	for (auto&& editor : editors_)
-	{
-		for (auto&& widget : editor->widgets()) result.insert(widget);
-	}
-	return result;
+	dragSelected_.clear();
+	rubberBandIndex_.clear();
+	hasRubberBandIndex_ = false;
 }
 
-const std::unordered_set<Widget*> Delegate::selected() const
+void Delegate::buildRubberBandIndex()
 {
-	std::unordered_set<Widget*> result;
-	for (auto&& editor : editors_)
+	// Row index and global position per parent
+	std::unordered_map<QWidget*, std::pair<size_t, QPoint>> rows;
+	rubberBandIndex_.clear();
+
+	for (auto&& widget : widgets_)
 	{
-		for (auto&& widget : editor->widgets())
+		// Keys that are removed from their editor are hidden until they are deleted
+		if (widget->isHidden()) continue;
+
+		auto parent = widget->parentWidget();
+		auto it = rows.find(parent);
+		if (it == end(rows))
 		{
-			if (widget->isSelected()) result.insert(widget);
+			auto origin = parent->mapToGlobal(QPoint());
+			it = rows.emplace(parent, std::make_pair(rubberBandIndex_.size(), origin)).first;
+			rubberBandIndex_.push_back({ origin.y(), origin.y() + parent->height() - 1, 0, {} });
 		}
+
+		auto& row = rubberBandIndex_[it->second.first];
+		auto rect = widget->geometry().translated(it->second.second);
+		row.maxWidth = std::max(row.maxWidth, rect.width());
+		row.widgets.emplace_back(rect, widget);
 	}
-	return result;
+
+	// Rows don't overlap, so ordering them by top orders them by bottom as well
+	std::sort(begin(rubberBandIndex_), end(rubberBandIndex_), [](const RubberBandRow& a, const RubberBandRow& b) { return a.top < b.top; });
+	for (auto&& row : rubberBandIndex_)
+	{
+		std::sort(begin(row.widgets), end(row.widgets), [](const std::pair<QRect, Widget*>& a, const std::pair<QRect, Widget*>& b) { return a.first.left() < b.first.left(); });
+	}
+
+	hasRubberBandIndex_ = true;
 }
 
 void Delegate::widgetCreated(Widget* widget)
 {
+	widgets_.insert(widget);
+	if (widget->isSelected()) selected_.insert(widget);
+	hasRubberBandIndex_ = false;
+
+	connect(widget, &Widget::selectionChanged, this, [=](bool selected) { widgetSelectionChanged(widget, selected); });
+	connect(widget, &QObject::destroyed, this, [=](QObject*) { widgetDestroyed(widget); });
 	connect(widget, &Widget::clicked, this, &Delegate::widgetClicked);
 	connect(widget, &Widget::dragged, this, &Delegate::widgetDragged);
 	connect(widget, &Widget::trimmed, this, &Delegate::widgetTrimmed);
 	connect(widget, &Widget::released, this, &Delegate::widgetReleased);
 }
 
+void Delegate::widgetSelectionChanged(Widget* widget, bool selected)
+{
+	if (selected) selected_.insert(widget);
+	else selected_.erase(widget);
+}
+
+void Delegate::widgetDestroyed(Widget* widget)
+{
+	// Only the pointer is used here, since the widget is already partially destroyed
+	widgets_.erase(widget);
+	selected_.erase(widget);
+	dragSelected_.erase(widget);
+	hasRubberBandIndex_ = false;
+}
+
 void Delegate::widgetClicked(bool multiSelect)
 {
 	auto widget = qobject_cast<Widget*>(sender());
@@ -33,6 +33,10 @@ public:
 	void deleteSelected();
 
 	void setRubberBandSelection(QRect globalRect);
+	void endRubberBandSelection();
+
+	// Widgets move when the view scrolls, so the rubber band has to look up where they are again
+	void invalidateRubberBandIndex() noexcept { hasRubberBandIndex_ = false; }
 
 	Editors::NodeEditor* editorFor(Core::NodePtr node) const;
 	Editors::PropertyEditor* editorFor(Core::PropertyPtr property) const;
@@ -47,8 +51,12 @@ public slots:
 private:
 	QWidget* createEditor(QWidget* parent, const QStyleOptionViewItem& option, const QModelIndex& index) const override;
 
-	const std::unordered_set<Widget*> widgets() const;
-	const std::unordered_set<Widget*> selected() const;
+	const std::unordered_set<Widget*>& widgets() const noexcept { return widgets_; }
+	const std::unordered_set<Widget*>& selected() const noexcept { return selected_; }
+
+	void widgetSelectionChanged(Widget* widget, bool selected);
+	void widgetDestroyed(Widget* widget);
+	void buildRubberBandIndex();
 
 	Core::Project& project_;
 	const QSortFilterProxyModel& proxy_;
@@ -56,8 +64,24 @@ private:
 
 	mutable std::unordered_set<RowEditor*> editors_;
 
+	// Kept up to date as widgets are created, destroyed and (de)selected, instead of asking every editor
+	std::unordered_set<Widget*> widgets_;
+	std::unordered_set<Widget*> selected_;
+
 	// The widgets that are selected by rubber band drag, but were not selected previously
 	std::unordered_set<Widget*> dragSelected_;
+
+	// Widgets in global coordinates for the rubber band drag in progress: rows ordered from top to bottom, and
+	// the widgets of a row ordered by left edge. Built when the drag starts, and again when widgets are created,
+	// destroyed or scrolled during it.
+	struct RubberBandRow
+	{
+		int top, bottom;
+		int maxWidth;
+		std::vector<std::pair<QRect, Widget*>> widgets;
+	};
+	std::vector<RubberBandRow> rubberBandIndex_;
+	bool hasRubberBandIndex_ {};
 };
 
 END_NAMESPACE(Editor) END_NAMESPACE(Modules) END_NAMESPACE(Timeline) END_NAMESPACE(Keyframer)
\ No newline at end of file
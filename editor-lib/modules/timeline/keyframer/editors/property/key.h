@@ -12,6 +12,9 @@ public:
 	Key(Core::Frame frame, Core::PropertyValue value, RowEditor* parent);
 
 	void setFrame(Core::Frame frame);
+
+	// Reuses the widget for a key that is now in the document at frame
+	void reset(Core::Frame frame, Core::PropertyValue value);
 	Core::Frame frame() const { return frame_; }
 	Core::Frame originalFrame() const { return originalFrame_; }
 
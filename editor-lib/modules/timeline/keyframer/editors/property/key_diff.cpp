@@ -0,0 +1,39 @@
+#include "key_diff.h"
+
+using Core::Frame;
+using Editor::Modules::Timeline::Keyframer::Editors::Property::KeyDiff;
+
+KeyDiff Editor::Modules::Timeline::Keyframer::Editors::Property::diffKeys(const std::vector<Frame>& widgetFrames, const std::vector<Frame>& keys)
+{
+	KeyDiff diff;
+
+	// Widgets can be on top of each other halfway a drag, so a frame may have more than one
+	std::unordered_multimap<Frame, size_t> widgets;
+	widgets.reserve(widgetFrames.size());
+	for (size_t i = 0; i < widgetFrames.size(); i++) widgets.emplace(widgetFrames[i], i);
+
+	std::vector<size_t> unmatchedKeys;
+	for (size_t i = 0; i < keys.size(); i++)
+	{
+		auto it = widgets.find(keys[i]);
+		if (it == end(widgets))
+		{
+			unmatchedKeys.push_back(i);
+			continue;
+		}
+
+		diff.kept.emplace_back(it->second, i);
+		widgets.erase(it);
+	}
+
+	std::vector<size_t> unmatchedWidgets;
+	for (auto&& widget : widgets) unmatchedWidgets.push_back(widget.second);
+	std::sort(begin(unmatchedWidgets), end(unmatchedWidgets));
+
+	auto moved = std::min(unmatchedWidgets.size(), unmatchedKeys.size());
+	for (size_t i = 0; i < moved; i++) diff.moved.emplace_back(unmatchedWidgets[i], unmatchedKeys[i]);
+	diff.added.assign(begin(unmatchedKeys) + moved, end(unmatchedKeys));
+	diff.removed.assign(begin(unmatchedWidgets) + moved, end(unmatchedWidgets));
+
+	return diff;
+}
\ No newline at end of file
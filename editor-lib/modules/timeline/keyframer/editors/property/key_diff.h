@@ -0,0 +1,21 @@
+#pragma once
+#include <editor-lib/static.h>
+
+BEGIN_NAMESPACE(Editor) BEGIN_NAMESPACE(Modules) BEGIN_NAMESPACE(Timeline) BEGIN_NAMESPACE(Keyframer) BEGIN_NAMESPACE(Editors) BEGIN_NAMESPACE(Property)
+
+// How the key widgets of a property editor map onto the keys of a mutated property. Widgets are matched on the frame
+// they show, so after a drag all of them are kept. Unmatched widgets are moved to the unmatched keys, and only the
+// difference in count has to be created or destroyed.
+struct KeyDiff
+{
+	using match_t = std::pair<size_t, size_t>;
+
+	std::vector<match_t> kept;   // widget index, key index: same frame
+	std::vector<match_t> moved;  // widget index, key index: different frame
+	std::vector<size_t> added;   // key index that needs a new widget
+	std::vector<size_t> removed; // widget index that has no key anymore
+};
+
+KeyDiff diffKeys(const std::vector<Core::Frame>& widgetFrames, const std::vector<Core::Frame>& keys);
+
+END_NAMESPACE(Editor) END_NAMESPACE(Modules) END_NAMESPACE(Timeline) END_NAMESPACE(Keyframer) END_NAMESPACE(Editors) END_NAMESPACE(Property)
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "../widget.h"
 #include "../../model.h"
 #include "property/key.h"
+#include "property/key_diff.h"
 
 #include <core/project.h>
 
@@ -18,6 +19,7 @@ using Editor::Modules::Timeline::Keyframer::TrimEdge;
 using Editor::Modules::Timeline::Keyframer::Widget;
 using Editor::Modules::Timeline::Keyframer::Editors::PropertyEditor;
 using Editor::Modules::Timeline::Keyframer::Editors::Property::Key;
+using Editor::Modules::Timeline::Keyframer::Editors::Property::diffKeys;
 
 PropertyEditor::PropertyEditor(Delegate& delegate, Project& project, const Model& model, QWidget* parent, PropertyPtr property)
 	: RowEditor(delegate, project, model, parent)
@@ -60,27 +62,55 @@ void PropertyEditor::updateProperty(PropertyPtr prevProperty, PropertyPtr curPro
 	property_ = curProperty;
 
 	std::unordered_set<Core::Frame> wasSelected;
-
+	std::vector<Core::Frame> widgetFrames;
 	for (const auto& key : keys_)
 	{
 		if (key->isSelected()) wasSelected.insert(key->frame());
-		key->deleteLater();
+		widgetFrames.push_back(key->frame());
 	}
-	keys_.clear();
 
-	for (const auto& frame : property_->keys())
+	// Only create and destroy widgets for keys that were added or removed, the rest are reused
+	auto& frames = property_->keys();
+	auto diff = diffKeys(widgetFrames, frames);
+	std::vector<Key*> keys(frames.size());
+
+	for (auto&& kept : diff.kept)
 	{
-		auto key = new Key(frame, property_->getPropertyValue(frame), this);
+		auto key = keys_[kept.first];
+		key->reset(frames[kept.second], property_->getPropertyValue(frames[kept.second]));
+		keys[kept.second] = key;
+	}
+
+	for (auto&& moved : diff.moved)
+	{
+		auto key = keys_[moved.first];
+		auto frame = frames[moved.second];
+		key->reset(frame, property_->getPropertyValue(frame));
+		key->setSelected(wasSelected.find(frame) != end(wasSelected));
+		keys[moved.second] = key;
+	}
 
-		auto selected = wasSelected.find(key->frame()) != end(wasSelected);
-		key->setSelected(selected);
+	// Deselected right away, so the delegate doesn't act on removed keys before they are destroyed
+	for (auto&& removed : diff.removed)
+	{
+		keys_[removed]->setSelected(false);
+		keys_[removed]->hide();
+		keys_[removed]->deleteLater();
+	}
 
-		keys_.emplace_back(key);
+	for (auto&& added : diff.added)
+	{
+		auto frame = frames[added];
+		auto key = new Key(frame, property_->getPropertyValue(frame), this);
+		key->setSelected(wasSelected.find(frame) != end(wasSelected));
+		keys[added] = key;
 		key->show();
 
 		emit widgetCreated(key);
 	}
 
+	keys_ = std::move(keys);
+
 	updateParentGeometry();
 }
 
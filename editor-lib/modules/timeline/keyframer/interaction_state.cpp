@@ -0,0 +1,59 @@
+#include "interaction_state.h"
+
+using Core::Frame;
+using Core::Uuid;
+using Editor::Modules::Timeline::Keyframer::InteractionState;
+using Editor::Modules::Timeline::Keyframer::TrimEdge;
+
+size_t InteractionState::KeyHash::operator()(const Key& key) const noexcept
+{
+	auto h = std::hash<Uuid>()(key.node);
+	h ^= std::hash<Core::HashValue>()(key.property) + 0x9e3779b9 + (h << 6) + (h >> 2);
+	h ^= std::hash<Frame>()(key.frame) + 0x9e3779b9 + (h << 6) + (h >> 2);
+	return h;
+}
+
+void InteractionState::setSelected(const Uuid& node, bool selected)
+{
+	if (selected) selectedNodes_.insert(node);
+	else selectedNodes_.erase(node);
+}
+
+void InteractionState::setSelected(const Key& key, bool selected)
+{
+	if (selected) selectedKeys_.insert(key);
+	else selectedKeys_.erase(key);
+}
+
+void InteractionState::clear()
+{
+	selectedNodes_.clear();
+	selectedKeys_.clear();
+}
+
+void InteractionState::startDrag(DragType type, TrimEdge edge, nodes_t nodes, keys_t keys)
+{
+	dragType_ = type;
+	trimEdge_ = edge;
+	dragOffset_ = 0;
+	draggedNodes_ = std::move(nodes);
+	draggedKeys_ = std::move(keys);
+}
+
+void InteractionState::endDrag()
+{
+	dragType_ = DragType::None;
+	dragOffset_ = 0;
+	draggedNodes_.clear();
+	draggedKeys_.clear();
+}
+
+void InteractionState::moveSelectedKeys(const keys_t& keys, Frame offset)
+{
+	keys_t moved;
+	for (auto&& key : keys)
+	{
+		if (selectedKeys_.erase(key)) moved.insert({ key.node, key.property, key.frame + offset });
+	}
+	selectedKeys_.insert(begin(moved), end(moved));
+}
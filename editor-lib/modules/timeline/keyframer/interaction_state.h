@@ -0,0 +1,73 @@
+#pragma once
+#include <editor-lib/static.h>
+#include <core/uuid.h>
+
+BEGIN_NAMESPACE(Editor) BEGIN_NAMESPACE(Modules) BEGIN_NAMESPACE(Timeline) BEGIN_NAMESPACE(Keyframer)
+
+enum class TrimEdge;
+
+// What is selected and dragged in the virtualized keyframer, which has no widgets to keep this in. Nodes are kept by
+// uuid and keys by node, property and frame, so the state stays valid when a mutation replaces the nodes.
+class InteractionState
+{
+public:
+	struct Key
+	{
+		Core::Uuid node;
+		Core::HashValue property;
+		Core::Frame frame;
+
+		friend bool operator==(const Key& lhs, const Key& rhs)
+		{
+			return lhs.node == rhs.node && lhs.property == rhs.property && lhs.frame == rhs.frame;
+		}
+	};
+
+	struct KeyHash
+	{
+		size_t operator()(const Key& key) const noexcept;
+	};
+
+	using nodes_t = std::unordered_set<Core::Uuid>;
+	using keys_t = std::unordered_set<Key, KeyHash>;
+
+	enum class DragType { None, Move, Trim };
+
+	bool isSelected(const Core::Uuid& node) const noexcept { return selectedNodes_.count(node) > 0; }
+	bool isSelected(const Key& key) const noexcept { return selectedKeys_.count(key) > 0; }
+	void setSelected(const Core::Uuid& node, bool selected);
+	void setSelected(const Key& key, bool selected);
+	void clear();
+
+	const nodes_t& selectedNodes() const noexcept { return selectedNodes_; }
+	const keys_t& selectedKeys() const noexcept { return selectedKeys_; }
+
+	// A drag takes along the given nodes and keys, and is only applied to the document once it ends.
+	// Until then the dragged items are drawn at their offset.
+	void startDrag(DragType type, TrimEdge edge, nodes_t nodes, keys_t keys);
+	void dragBy(Core::Frame offset) noexcept { dragOffset_ += offset; }
+	void endDrag();
+
+	DragType dragType() const noexcept { return dragType_; }
+	TrimEdge trimEdge() const noexcept { return trimEdge_; }
+	Core::Frame dragOffset() const noexcept { return dragOffset_; }
+	bool isDragged(const Core::Uuid& node) const noexcept { return draggedNodes_.count(node) > 0; }
+	bool isDragged(const Key& key) const noexcept { return draggedKeys_.count(key) > 0; }
+	const nodes_t& draggedNodes() const noexcept { return draggedNodes_; }
+	const keys_t& draggedKeys() const noexcept { return draggedKeys_; }
+
+	// Moves the selected keys along with a drag that was applied to the document
+	void moveSelectedKeys(const keys_t& keys, Core::Frame offset);
+
+private:
+	nodes_t selectedNodes_;
+	keys_t selectedKeys_;
+
+	DragType dragType_ { DragType::None };
+	TrimEdge trimEdge_ {};
+	Core::Frame dragOffset_ {};
+	nodes_t draggedNodes_;
+	keys_t draggedKeys_;
+};
+
+END_NAMESPACE(Editor) END_NAMESPACE(Modules) END_NAMESPACE(Timeline) END_NAMESPACE(Keyframer)
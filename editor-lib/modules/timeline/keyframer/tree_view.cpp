@@ -6,18 +6,37 @@
 #include "widget.h"
 #include "row_editor.h"
 #include "../model.h"
+#include "../../../event_bus.h"
 
 using Core::Document;
-using Core::Project;
-using Core::NodePtr;
 using Core::Frame;
+using Core::HashValue;
+using Core::Node;
+using Core::NodePtr;
+using Core::Project;
+using Core::Property;
+using Core::PropertyPtr;
+using Core::PropertyValue;
+using Core::Uuid;
+using Editor::EventBus;
 using Editor::Modules::Timeline::Keyframer::Delegate;
+using Editor::Modules::Timeline::Keyframer::InteractionState;
+using Editor::Modules::Timeline::Keyframer::TrimEdge;
 using Editor::Modules::Timeline::Keyframer::Widget;
 using Editor::Modules::Timeline::Keyframer::TreeView;
 using Editor::Modules::Timeline::Model;
 
+using DragType = InteractionState::DragType;
+
+// Sizes match the widgets of the row editors: keys are drawn as 12 pixel dots, and trim handles are 5 pixels wide
+static const int keyRadius = 6;
+static const int handleReach = 3;
+
 TreeView::TreeView(Project& project, QSortFilterProxyModel& proxy, Model& model, QWidget* parent)
 	: QTreeView(parent)
+	, project_(project)
+	, proxy_(proxy)
+	, model_(model)
 	, rubberBand_(new QRubberBand(QRubberBand::Rectangle, this))
 {
 	setIndentation(0);
@@ -30,11 +49,24 @@ TreeView::TreeView(Project& project, QSortFilterProxyModel& proxy, Model& model,
 
 	connect(this, &QTreeView::expanded, this, [&](const QModelIndex& index) { expanded_.insert(proxy.mapToSource(index)); });
 	connect(this, &QTreeView::collapsed, this, [&](const QModelIndex& index) { expanded_.remove(proxy.mapToSource(index)); });
+
+	// Scrolling moves the row editors, and with them the widgets a rubber band drag selects
+	connect(verticalScrollBar(), &QScrollBar::valueChanged, this, [this]() { delegate_->invalidateRubberBandIndex(); });
+	connect(horizontalScrollBar(), &QScrollBar::valueChanged, this, [this]() { delegate_->invalidateRubberBandIndex(); });
+
+	// Node selection is shared with the rest of the editor; the row editors do this themselves in widget mode
+	connect(&EventBus::instance(), &EventBus::nodeSelectionChanged, this, [this](NodePtr node, bool selected)
+	{
+		if (!virtualized_ || state_.isSelected(node->uuid()) == selected) return;
+		state_.setSelected(node->uuid(), selected);
+		viewport()->update();
+	});
 }
 
 void TreeView::deleteSelected()
 {
-	delegate_->deleteSelected();
+	if (virtualized_) deleteVirtualSelection();
+	else delegate_->deleteSelected();
 }
 
 QModelIndexList TreeView::expanded() const
@@ -47,29 +79,132 @@ QModelIndexList TreeView::expanded() const
 	return list;
 }
 
+void TreeView::setVirtualized(bool virtualized)
+{
+	if (virtualized_ == virtualized) return;
+
+	// Deselecting notifies the rest of the editor, which would otherwise keep showing the nodes as selected
+	resetVirtualSelection();
+	state_.endDrag();
+	virtualized_ = virtualized;
+
+	pressed_ = Hit();
+	viewport()->update();
+}
+
 void TreeView::drawRow(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const
 {
-	// Don't want to show the actual row, since we're showing an editor instead
-	//QTreeView::drawRow(painter, option, index);
+	// In widget mode the row shows an editor instead
+	if (!virtualized_) return;
+
+	auto& settings = project_.current().settings();
+	auto origin = frameOrigin();
+	auto toX = [&](Frame frame) { return origin + static_cast<int>(frame); };
+
+	QRect row(toX(settings.visibility.first), option.rect.top() + 1, static_cast<int>(settings.visibility.second - settings.visibility.first), option.rect.height() - 1);
+
+	// The range of a node as it is drawn, which includes a drag that is in progress
+	auto span = [&](const NodePtr& node)
+	{
+		auto visibility = node->visibility();
+		if (state_.isDragged(node->uuid()))
+		{
+			if (state_.dragType() == DragType::Move || state_.trimEdge() == TrimEdge::Start) visibility.first += state_.dragOffset();
+			if (state_.dragType() == DragType::Move || state_.trimEdge() == TrimEdge::Stop) visibility.second += state_.dragOffset();
+		}
+		return QRect(toX(visibility.first), row.top(), static_cast<int>(visibility.second - visibility.first), row.height());
+	};
+
+	painter->save();
+	painter->fillRect(row, QColor(0x33, 0x33, 0x33));
+	painter->setPen(QColor(0x44, 0x44, 0x44));
+	painter->drawLine(row.topLeft(), row.topRight());
+
+	// Like the parent area of the row editors
+	if (auto parent = nodeAt(index.parent())) painter->fillRect(span(parent), QColor(64, 64, 80, 128));
+
+	if (auto node = nodeAt(index))
+	{
+		auto area = span(node);
+		auto color = state_.isSelected(node->uuid()) ? QColor(160, 160, 160) : QColor(125, 125, 125);
+
+		painter->setPen(Qt::NoPen);
+		painter->setBrush(color);
+		painter->drawRect(area);
+
+		painter->setPen(color.darker());
+		painter->drawLine(area.topLeft(), area.topRight());
+		painter->setPen(color.lighter());
+		painter->drawLine(area.topLeft() + QPoint(0, 1), area.topRight() + QPoint(0, 1));
+	}
+	else if (auto prop = propertyAt(index))
+	{
+		auto node = nodeAt(index.parent());
+		auto nodeMoved = state_.dragType() == DragType::Move && state_.isDragged(node->uuid());
+
+		painter->setRenderHint(QPainter::Antialiasing);
+		painter->setPen(Qt::NoPen);
+		for (auto&& frame : prop->keys())
+		{
+			InteractionState::Key key { node->uuid(), prop->metadata().hash(), frame };
+			auto drawnFrame = nodeMoved || state_.isDragged(key) ? frame + state_.dragOffset() : frame;
+
+			painter->setBrush(state_.isSelected(key) ? QColor(200, 200, 200) : QColor(160, 160, 160));
+			painter->drawEllipse(QPoint(toX(drawnFrame), row.center().y()), keyRadius, keyRadius);
+		}
+	}
+
+	painter->restore();
 }
 
 void TreeView::mousePressEvent(QMouseEvent* event)
 {
 	if (event->button() == Qt::LeftButton)
 	{
+		if (virtualized_)
+		{
+			pressed_ = hitTest(event->pos());
+			if (pressed_.type != Hit::Type::None)
+			{
+				isClicking_ = true;
+				pressX_ = event->globalPos().x();
+				return;
+			}
+		}
+
 		isDragging_ = true;
 		dragPos_ = event->globalPos();
-		if (!(event->modifiers() & Qt::ControlModifier)) delegate_->resetSelection();
+		if (!(event->modifiers() & Qt::ControlModifier))
+		{
+			if (virtualized_) resetVirtualSelection();
+			else delegate_->resetSelection();
+		}
 	}
 }
 
 void TreeView::mouseMoveEvent(QMouseEvent* event)
 {
+	if (virtualized_ && pressed_.type != Hit::Type::None && (event->buttons() & Qt::LeftButton))
+	{
+		if (isClicking_)
+		{
+			isClicking_ = false;
+			startDrag(pressed_);
+		}
+
+		state_.dragBy(static_cast<Frame>(event->globalPos().x() - pressX_));
+		pressX_ = event->globalPos().x();
+		viewport()->update();
+		return;
+	}
+
 	if (isDragging_)
 	{
 		rubberBand_->setGeometry(QRect(mapFromGlobal(dragPos_), mapFromGlobal(event->globalPos())).normalized());
 		rubberBand_->show();
-		delegate_->setRubberBandSelection(QRect(dragPos_, event->globalPos()).normalized());
+
+		if (virtualized_) selectInRect(QRect(viewport()->mapFromGlobal(dragPos_), viewport()->mapFromGlobal(event->globalPos())).normalized());
+		else delegate_->setRubberBandSelection(QRect(dragPos_, event->globalPos()).normalized());
 	}
 }
 
@@ -77,7 +212,327 @@ void TreeView::mouseReleaseEvent(QMouseEvent* event)
 {
 	if (event->button() == Qt::LeftButton)
 	{
+		if (virtualized_ && pressed_.type != Hit::Type::None)
+		{
+			if (isClicking_) click(pressed_, event->modifiers() & Qt::ControlModifier);
+			else applyDrag();
+
+			pressed_ = Hit();
+			isClicking_ = false;
+			return;
+		}
+
 		isDragging_ = false;
 		rubberBand_->hide();
+		delegate_->endRubberBandSelection();
+		dragSelectedNodes_.clear();
+		dragSelectedKeys_.clear();
+	}
+}
+
+NodePtr TreeView::nodeAt(const QModelIndex& index) const
+{
+	if (!index.isValid()) return nullptr;
+	return model_.nodeFromIndex(proxy_.mapToSource(index));
+}
+
+PropertyPtr TreeView::propertyAt(const QModelIndex& index) const
+{
+	if (!index.isValid()) return nullptr;
+	return model_.propertyFromIndex(proxy_.mapToSource(index));
+}
+
+int TreeView::frameOrigin() const
+{
+	return header()->sectionViewportPosition(static_cast<int>(Model::Columns::Item));
+}
+
+TreeView::Hit TreeView::hitTest(const QPoint& pos) const
+{
+	Hit hit;
+
+	// Rows are painted across the whole viewport, but the item column is only as wide as its contents
+	auto index = indexAt(QPoint(std::max(frameOrigin(), 0), pos.y()));
+	auto frame = static_cast<Frame>(pos.x() - frameOrigin());
+
+	if (auto node = nodeAt(index))
+	{
+		auto visibility = node->visibility();
+		hit.node = node;
+		hit.frame = frame;
+
+		if (std::abs(frame - visibility.first) <= handleReach) hit.type = Hit::Type::TrimStart;
+		else if (std::abs(frame - visibility.second) <= handleReach) hit.type = Hit::Type::TrimStop;
+		else if (frame > visibility.first && frame < visibility.second) hit.type = Hit::Type::Node;
 	}
+	else if (auto prop = propertyAt(index))
+	{
+		// The closest key within reach
+		Frame closest = keyRadius;
+		for (auto&& key : prop->keys())
+		{
+			auto distance = std::abs(key - frame);
+			if (distance > closest) continue;
+
+			closest = distance;
+			hit.type = Hit::Type::Key;
+			hit.frame = key;
+		}
+
+		hit.node = nodeAt(index.parent());
+		hit.property = prop;
+	}
+
+	return hit;
+}
+
+void TreeView::setNodeSelected(const Uuid& node, bool selected)
+{
+	if (state_.isSelected(node) == selected) return;
+	state_.setSelected(node, selected);
+
+	auto found = project_.current().find(node);
+	if (found) emit EventBus::instance().nodeSelectionChanged(found, selected);
+}
+
+void TreeView::resetVirtualSelection()
+{
+	auto nodes = state_.selectedNodes();
+	for (auto&& node : nodes) setNodeSelected(node, false);
+	state_.clear();
+	viewport()->update();
+}
+
+void TreeView::click(const Hit& hit, bool multiSelect)
+{
+	if (hit.type == Hit::Type::Key)
+	{
+		InteractionState::Key key { hit.node->uuid(), hit.property->metadata().hash(), hit.frame };
+		auto selected = multiSelect ? !state_.isSelected(key) : true;
+		if (!multiSelect) resetVirtualSelection();
+		state_.setSelected(key, selected);
+	}
+	else
+	{
+		auto selected = multiSelect ? !state_.isSelected(hit.node->uuid()) : true;
+		if (!multiSelect) resetVirtualSelection();
+		setNodeSelected(hit.node->uuid(), selected);
+	}
+
+	viewport()->update();
+}
+
+void TreeView::startDrag(const Hit& hit)
+{
+	auto& document = project_.current();
+	auto type = hit.type == Hit::Type::TrimStart || hit.type == Hit::Type::TrimStop ? DragType::Trim : DragType::Move;
+	auto edge = hit.type == Hit::Type::TrimStop ? TrimEdge::Stop : TrimEdge::Start;
+
+	// Like the row editors, a drag takes along the selection and the item it started on, and nodes take their children
+	std::vector<Uuid> pending(begin(state_.selectedNodes()), end(state_.selectedNodes()));
+	if (hit.type != Hit::Type::Key) pending.push_back(hit.node->uuid());
+
+	InteractionState::nodes_t nodes;
+	while (!pending.empty())
+	{
+		auto uuid = pending.back();
+		pending.pop_back();
+		if (!nodes.insert(uuid).second) continue;
+
+		auto node = document.find(uuid);
+		if (!node) continue;
+		for (size_t i = 0; i < document.childCount(*node); i++) pending.push_back(document.child(*node, i)->uuid());
+	}
+
+	InteractionState::keys_t keys;
+	if (type == DragType::Move)
+	{
+		keys = state_.selectedKeys();
+		if (hit.type == Hit::Type::Key) keys.insert({ hit.node->uuid(), hit.property->metadata().hash(), hit.frame });
+	}
+
+	state_.startDrag(type, edge, std::move(nodes), std::move(keys));
+}
+
+void TreeView::applyDrag()
+{
+	auto type = state_.dragType();
+	auto edge = state_.trimEdge();
+	auto offset = state_.dragOffset();
+	auto nodes = state_.draggedNodes();
+	auto keys = state_.draggedKeys();
+	state_.endDrag();
+	viewport()->update();
+
+	if (type == DragType::None || offset == 0) return;
+
+	// Keys of moved nodes move along, so only the other keys have to be moved by themselves
+	std::unordered_map<Uuid, std::unordered_map<HashValue, std::vector<Frame>>> movedKeys;
+	if (type == DragType::Move)
+	{
+		InteractionState::keys_t selectedMoved = keys;
+		for (auto&& key : state_.selectedKeys()) if (nodes.count(key.node)) selectedMoved.insert(key);
+		state_.moveSelectedKeys(selectedMoved, offset);
+
+		for (auto&& key : keys) if (!nodes.count(key.node)) movedKeys[key.node][key.property].push_back(key.frame);
+	}
+
+	auto& document = project_.current();
+	auto moveKeys = [&](Node::Builder& builder, const PropertyPtr& prop, const std::vector<Frame>& frames)
+	{
+		builder.mutateProperty(prop, [&](Property::Builder& pb)
+		{
+			// Erase all keys before setting any, so keys that move onto each other's frames are not lost
+			std::vector<PropertyValue> values;
+			for (auto&& frame : frames)
+			{
+				values.push_back(prop->getPropertyValue(frame));
+				pb.erase(frame);
+			}
+			for (size_t i = 0; i < frames.size(); i++) pb.set(frames[i] + offset, values[i]);
+		});
+	};
+
+	project_.mutate([&](Document::Builder& mut)
+	{
+		for (auto&& uuid : nodes)
+		{
+			auto node = document.find(uuid);
+			if (!node) continue;
+
+			mut.mutate(node, [&](Node::Builder& builder)
+			{
+				auto visibility = node->visibility();
+				if (type == DragType::Move || edge == TrimEdge::Start) visibility.first += offset;
+				if (type == DragType::Move || edge == TrimEdge::Stop) visibility.second += offset;
+				builder.mutateVisibility(visibility);
+
+				if (type != DragType::Move) return;
+				for (auto&& prop : node->properties())
+				{
+					// Internal properties have no row, so they stay where they are
+					if (prop->keys().empty() || prop->metadata().title().at(0) == '$') continue;
+					moveKeys(builder, prop, prop->keys());
+				}
+			});
+		}
+
+		for (auto&& nodeKeys : movedKeys)
+		{
+			auto node = document.find(nodeKeys.first);
+			if (!node) continue;
+
+			mut.mutate(node, [&](Node::Builder& builder)
+			{
+				for (auto&& prop : node->properties())
+				{
+					auto it = nodeKeys.second.find(prop->metadata().hash());
+					if (it != end(nodeKeys.second)) moveKeys(builder, prop, it->second);
+				}
+			});
+		}
+	}, type == DragType::Move ? "Move" : "Change visibility");
+}
+
+void TreeView::selectInRect(const QRect& rect)
+{
+	auto origin = frameOrigin();
+	InteractionState::nodes_t nodes;
+	InteractionState::keys_t keys;
+
+	// Only the rows the band covers are visited
+	auto index = indexAt(QPoint(std::max(origin, 0), std::max(rect.top(), 0)));
+	for (; index.isValid() && visualRect(index).top() <= rect.bottom(); index = indexBelow(index))
+	{
+		auto row = visualRect(index);
+
+		if (auto node = nodeAt(index))
+		{
+			auto visibility = node->visibility();
+			QRect area(origin + static_cast<int>(visibility.first), row.top(), static_cast<int>(visibility.second - visibility.first), row.height());
+			if (rect.intersects(area)) nodes.insert(node->uuid());
+		}
+		else if (auto prop = propertyAt(index))
+		{
+			auto node = nodeAt(index.parent());
+			for (auto&& frame : prop->keys())
+			{
+				QRect area(origin + static_cast<int>(frame) - keyRadius, row.center().y() - keyRadius, keyRadius * 2, keyRadius * 2);
+				if (rect.intersects(area)) keys.insert({ node->uuid(), prop->metadata().hash(), frame });
+			}
+		}
+	}
+
+	// Select what came into the band, and deselect what the band selected before but has left it since
+	for (auto&& node : nodes)
+	{
+		if (state_.isSelected(node)) continue;
+		dragSelectedNodes_.insert(node);
+		setNodeSelected(node, true);
+	}
+	for (auto it = begin(dragSelectedNodes_); it != end(dragSelectedNodes_);)
+	{
+		if (nodes.count(*it)) { ++it; continue; }
+		setNodeSelected(*it, false);
+		it = dragSelectedNodes_.erase(it);
+	}
+
+	for (auto&& key : keys)
+	{
+		if (state_.isSelected(key)) continue;
+		dragSelectedKeys_.insert(key);
+		state_.setSelected(key, true);
+	}
+	for (auto it = begin(dragSelectedKeys_); it != end(dragSelectedKeys_);)
+	{
+		if (keys.count(*it)) { ++it; continue; }
+		state_.setSelected(*it, false);
+		it = dragSelectedKeys_.erase(it);
+	}
+
+	viewport()->update();
+}
+
+void TreeView::deleteVirtualSelection()
+{
+	auto& document = project_.current();
+
+	std::vector<NodePtr> nodes;
+	for (auto&& uuid : state_.selectedNodes())
+	{
+		auto node = document.find(uuid);
+		if (node) nodes.push_back(node);
+	}
+
+	// Keys of nodes that are deleted as a whole go with their node
+	std::unordered_map<Uuid, std::unordered_map<HashValue, std::vector<Frame>>> keyframes;
+	for (auto&& key : state_.selectedKeys())
+	{
+		if (!state_.isSelected(key.node)) keyframes[key.node][key.property].push_back(key.frame);
+	}
+
+	state_.clear();
+	if (nodes.empty() && keyframes.empty()) return;
+
+	project_.mutate([&](Document::Builder& mut)
+	{
+		for (auto&& nodeKeys : keyframes)
+		{
+			auto node = document.find(nodeKeys.first);
+			if (!node) continue;
+
+			mut.mutate(node, [&](Node::Builder& builder)
+			{
+				for (auto&& propKeys : nodeKeys.second)
+				{
+					builder.mutateProperty(propKeys.first, [&](Property::Builder& pb)
+					{
+						for (auto&& frame : propKeys.second) pb.erase(frame);
+					});
+				}
+			});
+		}
+
+		mut.erase(nodes);
+	}, "delete");
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 #include <editor-lib/static.h>
+#include "interaction_state.h"
 
 BEGIN_NAMESPACE(Editor) BEGIN_NAMESPACE(Modules) BEGIN_NAMESPACE(Timeline)
 
@@ -21,12 +22,45 @@ public:
 
 	QModelIndexList expanded() const;
 
+	// Without editor widgets, rows are painted when they become visible and the mouse is hit-tested against them.
+	// This keeps the cost of the keyframer proportional to what is on screen instead of to the number of rows.
+	void setVirtualized(bool virtualized);
+	bool isVirtualized() const noexcept { return virtualized_; }
+
 private:
+	// What is under the mouse in a virtualized row
+	struct Hit
+	{
+		enum class Type { None, Node, TrimStart, TrimStop, Key };
+
+		Type type { Type::None };
+		Core::NodePtr node;
+		Core::PropertyPtr property;
+		Core::Frame frame {};
+	};
+
 	void drawRow(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const override;
 	void mousePressEvent(QMouseEvent* event) override;
 	void mouseMoveEvent(QMouseEvent* event) override;
 	void mouseReleaseEvent(QMouseEvent* event) override;
 
+	Core::NodePtr nodeAt(const QModelIndex& index) const;
+	Core::PropertyPtr propertyAt(const QModelIndex& index) const;
+	int frameOrigin() const;
+	Hit hitTest(const QPoint& pos) const;
+
+	void setNodeSelected(const Core::Uuid& node, bool selected);
+	void resetVirtualSelection();
+	void click(const Hit& hit, bool multiSelect);
+	void startDrag(const Hit& hit);
+	void applyDrag();
+	void selectInRect(const QRect& rect);
+	void deleteVirtualSelection();
+
+	Core::Project& project_;
+	QSortFilterProxyModel& proxy_;
+	Model& model_;
+
 	QRubberBand* rubberBand_;
 	Delegate* delegate_;
 
@@ -34,6 +68,16 @@ private:
 	bool isDragging_ {};
 
 	QSet<QPersistentModelIndex> expanded_;
+
+	bool virtualized_ {};
+	InteractionState state_;
+	Hit pressed_;
+	int pressX_ {};
+	bool isClicking_ {};
+
+	// The items that are selected by rubber band drag, but were not selected previously
+	InteractionState::nodes_t dragSelectedNodes_;
+	InteractionState::keys_t dragSelectedKeys_;
 };
 
 END_NAMESPACE(Editor) END_NAMESPACE(Modules) END_NAMESPACE(Timeline) END_NAMESPACE(Keyframer)
\ No newline at end of file
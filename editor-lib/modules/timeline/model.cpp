@@ -19,14 +19,14 @@ using Core::Uuid;
 class Model::ModelItem: public QStandardItem
 {
 public:
-	explicit ModelItem(const Model* model, NodePtr node)
+	explicit ModelItem(Model* model, NodePtr node)
 		: model_(model)
 	{
 		setFlags(flags_);
 		update(node);
 	}
 
-	explicit ModelItem(const Model* model, PropertyPtr prop)
+	explicit ModelItem(Model* model, PropertyPtr prop)
 		: model_(model)
 		, propertyValueItem_(new PropertyValueItem(prop.get()))
 	{
@@ -52,6 +52,7 @@ public:
 		setData(QVariant::fromValue(node_), static_cast<int>(ModelItemRoles::Data));
 		setData(QVariant::fromValue<int>(static_cast<int>(ModelItemDataType::Node)), static_cast<int>(ModelItemRoles::Type));
 		setData(Core::prop<std::string>(*node, "$Title", 0).c_str(), Qt::DisplayRole);
+		model_->indexItem(this, prev, node);
 		emit model_->modelItemNodeMutated(prev, node);
 	}
 
@@ -63,6 +64,7 @@ public:
 		setData(QVariant::fromValue<int>(static_cast<int>(ModelItemDataType::Property)), static_cast<int>(ModelItemRoles::Type));
 		setData(prop->metadata().title().c_str(), Qt::DisplayRole);
 		propertyValueItem_->update(prop.get());
+		model_->indexItem(this, prev, prop);
 		emit model_->modelItemPropertyMutated(prev, prop);
 	}
 
@@ -83,7 +85,7 @@ public:
 	}
 
 private:
-	const Model* model_;
+	Model* model_;
 	NodePtr node_ {};
 	PropertyPtr prop_ {};
 	PropertyValueItem* propertyValueItem_ {};
@@ -130,51 +132,126 @@ std::vector<QStandardItem*> Model::apply(std::shared_ptr<Core::MutationInfo> mut
 
 	enum class RowType { Node, Property };
 
-	auto setRow = [&](QStandardItem* parent, size_t row, QList<QStandardItem*> items, RowType rowType)
+	// Rows go in the order of the current document. Rather than asking the document for the index of every sibling
+	// that is passed, the indices of all children of a parent are looked up once. Properties come below the nodes.
+	std::unordered_map<QStandardItem*, std::unordered_map<const void*, size_t>> rowIndices;
+	auto documentRows = [&](QStandardItem* parent) -> const std::unordered_map<const void*, size_t>&
 	{
+		auto it = rowIndices.find(parent);
+		if (it != end(rowIndices)) return it->second;
+
+		auto& indices = rowIndices[parent];
+		auto node = ModelItem::node(parent);
+		if (!node) node = mutation->cur.root();
+
+		auto& children = mutation->cur.nodes().children(node->uuid());
+		size_t index = 0;
+		for (auto&& child : children) indices[mutation->cur.find(child).get()] = index++;
+		for (size_t i = 0; i < node->properties().size(); i++) indices[node->properties()[i].get()] = children.size() + i;
+		return indices;
+	};
+
+	auto findRow = [&](QStandardItem* parent, size_t index, RowType rowType)
+	{
+		auto& indices = documentRows(parent);
 		if (rowType == RowType::Property)
 		{
-			// Properties are indexed from 0, but they should always go below the node children of the parent
-			// So increase the row offset by the number of children the parent has
-			row += mutation->cur.childCount(*ModelItem::node(parent));
+			auto node = ModelItem::node(parent);
+			index += mutation->cur.childCount(*node);
 		}
 
-		// When inserting a new item, make sure we above any items that have a higher index in the actual document
-		// If we are inserting a node, also make sure we stay above any properties
-		auto maxRow = row;
-		for (row = 0; row < maxRow; row++)
+		// Stay above any items that have a higher index in the document, and keep nodes above the properties.
+		// Rows that are not in the document anymore are about to be removed, so they do not count.
+		int row = 0;
+		size_t counted = 0;
+		for (; row < parent->rowCount() && counted < index; row++)
 		{
-			if (row == static_cast<size_t>(parent->rowCount())) break;
-
 			auto child = parent->child(row);
+			auto prop = ModelItem::prop(child);
+			if (rowType == RowType::Node && prop) break;
 
-			// Encountered a property, so stop
-			if (rowType == RowType::Node && ModelItem::prop(child)) break;
+			auto it = indices.find(prop ? static_cast<const void*>(prop.get()) : ModelItem::node(child).get());
+			if (it == end(indices)) continue;
+			if (it->second > index) break;
+			counted++;
+		}
+		return row;
+	};
 
-			size_t index;
+	// Rows added below items that are in the model are inserted at the end, one run of neighbouring rows at a time.
+	// Rows below items that were added by this mutation go in right away, as those are not in the model yet and
+	// nothing gets notified about them.
+	struct PendingRow
+	{
+		RowType type;
+		size_t index;
+		QList<QStandardItem*> items;
+	};
+	std::vector<QStandardItem*> insertParents;
+	std::unordered_map<QStandardItem*, std::vector<PendingRow>> inserts;
 
-			// Encountered a property that has a higher index than this item, so stop
-			auto prop = ModelItem::prop(child);
-			if (prop)
+	auto insertRow = [&](QStandardItem* parent, size_t index, QList<QStandardItem*> items, RowType rowType)
+	{
+		if (parent->model())
+		{
+			auto& rows = inserts[parent];
+			if (rows.empty()) insertParents.push_back(parent);
+			rows.push_back({ rowType, index, std::move(items) });
+		}
+		else parent->insertRow(findRow(parent, index, rowType), items);
+	};
+
+	auto flushInserts = [&]()
+	{
+		for (auto&& parent : insertParents)
+		{
+			// Nodes first, since the rows of the properties depend on the number of nodes
+			auto& rows = inserts[parent];
+			std::stable_sort(begin(rows), end(rows), [](auto& a, auto& b) { return std::make_pair(a.type, a.index) < std::make_pair(b.type, b.index); });
+
+			for (size_t i = 0; i < rows.size();)
 			{
-				auto propNode = mutation->cur.parent(*prop);
-				// add node childCount because the properties start BELOW the child nodes
-				index = mutation->cur.childIndex(*prop) + mutation->cur.childCount(*propNode);
-				if (index > maxRow) break;
+				auto row = findRow(parent, rows[i].index, rows[i].type);
+				auto j = i;
+				while (j < rows.size() && rows[j].type == rows[i].type && rows[j].index == rows[i].index + (j - i)) j++;
+
+				auto columns = rows[i].items.size();
+				if (parent->columnCount() < columns) parent->setColumnCount(columns);
+
+				// Node rows only have an item in the first column, so a run of them goes in with a single notification.
+				// Property rows have a value item as well. Setting that cell afterwards changes the layout of the model
+				// once per cell, so those rows go in one at a time, with all of their items.
+				if (rows[i].type == RowType::Node)
+				{
+					QList<QStandardItem*> items;
+					for (auto k = i; k < j; k++) items << rows[k].items.first();
+					parent->insertRows(row, items);
+					i = j;
+				}
+				else for (; i < j; i++, row++) parent->insertRow(row, rows[i].items);
 			}
+		}
+	};
+
+	// Removed rows are taken out at the end as well, as ranges of neighbouring rows, bottom up so the rows stay valid
+	std::vector<QStandardItem*> removeParents;
+	std::unordered_map<QStandardItem*, std::vector<int>> removes;
+
+	auto flushRemoves = [&]()
+	{
+		for (auto&& parent : removeParents)
+		{
+			auto& rows = removes[parent];
+			std::sort(begin(rows), end(rows), std::greater<int>());
 
-			// Encountered a node that has a higher index than this item, so stop
-			auto node = ModelItem::node(child);
-			if (node)
+			for (size_t i = 0; i < rows.size();)
 			{
-				index = mutation->cur.childIndex(*node);
-				if (index > maxRow) break;
+				auto j = i + 1;
+				while (j < rows.size() && rows[j] == rows[j - 1] - 1) j++;
+				parent->removeRows(rows[j - 1], static_cast<int>(j - i));
+				i = j;
 			}
 		}
-
-		//LOG->debug("row: {}, rowCount: {}", row, parent->rowCount());
-		if (row <= static_cast<size_t>(parent->rowCount())) parent->insertRow(row, items);
-		else parent->appendRow(items);
 	};
 
 	auto applyMutations = [&](auto& changes, RowType rowType, auto createItems, bool onlyRemove)
@@ -192,7 +269,7 @@ std::vector<QStandardItem*> Model::apply(std::shared_ptr<Core::MutationInfo> mut
 			{
 				if (onlyRemove) continue;
 				LOG->debug("Adding at position {}: {}", mut.curIndex, *mut.cur);
-				setRow(curParentNode, mut.curIndex, createItems(mut.cur), rowType);
+				insertRow(curParentNode, mut.curIndex, createItems(mut.cur), rowType);
 				break;
 			}
 			case ChangeType::Removed:
@@ -202,7 +279,14 @@ std::vector<QStandardItem*> Model::apply(std::shared_ptr<Core::MutationInfo> mut
 				if (!item) continue; // maybe was already deleted when parent was removed
 				removedItems.push_back(item);
 				auto childIndex = findChildIndex(prevParentNode, item);
-				if (childIndex != -1) prevParentNode->removeRow(childIndex);
+				if (childIndex != -1)
+				{
+					// Unindexing the whole row right away skips the removal of its children
+					unindexItem(item);
+					auto& rows = removes[prevParentNode];
+					if (rows.empty()) removeParents.push_back(prevParentNode);
+					rows.push_back(childIndex);
+				}
 				LOG->debug("Removed at position {}: {}", childIndex, *mut.prev);
 				break;
 			}
@@ -224,7 +308,7 @@ std::vector<QStandardItem*> Model::apply(std::shared_ptr<Core::MutationInfo> mut
 				{
 					// Move the row
 					auto itemRowItems = prevParentNode->takeRow(prevIndex);
-					setRow(curParentNode, mut.curIndex, itemRowItems, rowType);
+					curParentNode->insertRow(findRow(curParentNode, mut.curIndex, rowType), itemRowItems);
 				}
 
 				break;
@@ -248,8 +332,10 @@ std::vector<QStandardItem*> Model::apply(std::shared_ptr<Core::MutationInfo> mut
 	};
 	applyMutations(mutation->nodes, RowType::Node, createNodeItems, false);
 	applyMutations(mutation->properties, RowType::Property, createPropertyItems, false);
+	flushInserts();
 	applyMutations(mutation->nodes, RowType::Node, createNodeItems, true);
 	applyMutations(mutation->properties, RowType::Property, createPropertyItems, true);
+	flushRemoves();
 
 	return removedItems;
 }
@@ -277,11 +363,10 @@ QVariant Model::headerData(int section, Qt::Orientation orientation, int role) c
 
 int Model::findChildIndex(QStandardItem* parent, ModelItem* item) noexcept
 {
-	for (int row = 0; row < parent->rowCount(); row++)
-	{
-		if (parent->child(row) == item) return row;
-	}
-	return -1;
+	// Top level items report no parent, but the model has them under its invisible root item
+	auto itemParent = item->parent();
+	if (!itemParent && item->model()) itemParent = item->model()->invisibleRootItem();
+	return itemParent == parent ? item->row() : -1;
 }
 
 QModelIndex Model::findItemIndex(Core::NodePtr ptr) const noexcept
@@ -291,21 +376,62 @@ QModelIndex Model::findItemIndex(Core::NodePtr ptr) const noexcept
 	return item->index();
 }
 
-Model::ModelItem* Model::findItem(QVariant ptr) const noexcept
+QModelIndex Model::findItemIndex(const Uuid& uuid) const noexcept
 {
-	auto results = match(
-		index(0, 0),
-		static_cast<int>(ModelItemRoles::Data),
-		ptr,
-		1,
-		Qt::MatchRecursive);
-
-	if (results.isEmpty()) return nullptr;
-	return static_cast<ModelItem*>(itemFromIndex(results.at(0)));
+	auto item = findItem(uuid);
+	if (!item) return QModelIndex();
+	return item->index();
 }
 
-Model::ModelItem* Model::findItem(NodePtr ptr) const noexcept { return findItem(QVariant::fromValue(ptr)); }
-Model::ModelItem* Model::findItem(PropertyPtr ptr) const noexcept { return findItem(QVariant::fromValue(ptr)); }
+Model::ModelItem* Model::findItem(NodePtr ptr) const noexcept
+{
+	if (!ptr) return nullptr;
+	auto it = nodeItems_.find(ptr.get());
+	return it != end(nodeItems_) ? it->second : nullptr;
+}
+
+Model::ModelItem* Model::findItem(PropertyPtr ptr) const noexcept
+{
+	if (!ptr) return nullptr;
+	auto it = propertyItems_.find(ptr.get());
+	return it != end(propertyItems_) ? it->second : nullptr;
+}
+
+Model::ModelItem* Model::findItem(const Uuid& uuid) const noexcept
+{
+	auto it = uuidItems_.find(uuid);
+	return it != end(uuidItems_) ? it->second : nullptr;
+}
+
+void Model::indexItem(ModelItem* item, NodePtr prev, NodePtr cur) noexcept
+{
+	if (prev) nodeItems_.erase(prev.get());
+	nodeItems_[cur.get()] = item;
+	uuidItems_[cur->uuid()] = item;
+}
+
+void Model::indexItem(ModelItem* item, PropertyPtr prev, PropertyPtr cur) noexcept
+{
+	if (prev) propertyItems_.erase(prev.get());
+	propertyItems_[cur.get()] = item;
+}
+
+void Model::unindexItem(QStandardItem* item) noexcept
+{
+	// Removing a row deletes the items of all rows below it as well
+	for (int row = 0; row < item->rowCount(); row++)
+	{
+		if (auto child = item->child(row)) unindexItem(child);
+	}
+
+	auto modelItem = static_cast<ModelItem*>(item);
+	if (auto node = modelItem->node())
+	{
+		nodeItems_.erase(node.get());
+		uuidItems_.erase(node->uuid());
+	}
+	if (auto prop = modelItem->prop()) propertyItems_.erase(prop.get());
+}
 
 QSet<QStandardItem*> Model::indicesToItems(const QModelIndexList& indices) const noexcept
 {
@@ -29,6 +29,7 @@ public:
 	Core::NodePtr nodeFromIndex(const QModelIndex& index) const noexcept;
 	Core::PropertyPtr propertyFromIndex(const QModelIndex& index) const noexcept;
 	QModelIndex findItemIndex(Core::NodePtr ptr) const noexcept;
+	QModelIndex findItemIndex(const Core::Uuid& uuid) const noexcept;
 	
 	QSet<QStandardItem*> indicesToItems(const QModelIndexList& indices) const noexcept;
 	QModelIndexList itemsToIndices(const QSet<QStandardItem*> items) const noexcept;
@@ -44,9 +45,18 @@ signals:
 private:
 	static int findChildIndex(QStandardItem* parent, ModelItem* item) noexcept;
 
-	ModelItem* findItem(QVariant ptr) const noexcept;
 	ModelItem* findItem(Core::NodePtr ptr) const noexcept;
 	ModelItem* findItem(Core::PropertyPtr ptr) const noexcept;
+	ModelItem* findItem(const Core::Uuid& uuid) const noexcept;
+
+	// Items are looked up by what they hold, so these follow every item update, and every row that gets removed
+	void indexItem(ModelItem* item, Core::NodePtr prev, Core::NodePtr cur) noexcept;
+	void indexItem(ModelItem* item, Core::PropertyPtr prev, Core::PropertyPtr cur) noexcept;
+	void unindexItem(QStandardItem* item) noexcept;
+
+	std::unordered_map<const Core::Node*, ModelItem*> nodeItems_;
+	std::unordered_map<const Core::Property*, ModelItem*> propertyItems_;
+	std::unordered_map<Core::Uuid, ModelItem*> uuidItems_;
 };
 
 END_NAMESPACE(Editor) END_NAMESPACE(Modules) END_NAMESPACE(Timeline)
\ No newline at end of file
@@ -32,6 +32,14 @@ Editor::Modules::Metadata Editor::Modules::Timeline::registerModule()
 		return action;
 	}, "&Redo", ActionFlags::RequiresFocus);
 
+	m.addAction<Widget>([&](QObject* app, Widget* widget)
+	{
+		auto action = new QAction(app->tr("&Virtualized Keyframer"), app);
+		action->setCheckable(true);
+		action->connect(action, &QAction::toggled, widget, &Widget::setVirtualizedKeyframer);
+		return action;
+	}, "&Redo");
+
 	// Debug stuff
 
 	m.addAction<Widget>([&](QObject* app, Widget* widget)
@@ -100,26 +100,36 @@ void Widget::projectMutated(std::shared_ptr<MutationInfo> mutationInfo) const
 	// Hack to make sure we only see the item column in the keyframer
 	keyframer_->setColumnHidden(static_cast<int>(Model::Columns::Value), true);
 
-	// Update and create item widgets
-	updateItemWidgets(model_->invisibleRootItem());
+	// Update and create item widgets, or repaint the visible rows if there are none
+	if (keyframer_->isVirtualized()) keyframer_->viewport()->update();
+	else updateItemWidgets(model_->invisibleRootItem(), true);
 
 	// Apply the old selection and expansion again
 	for (auto&& index : model_->itemsToIndices(selection)) if (index != QModelIndex()) tree_->selectionModel()->select(proxy_->mapFromSource(index), QItemSelectionModel::Select | QItemSelectionModel::Rows);
 	for (auto&& index : model_->itemsToIndices(expanded)) if (index != QModelIndex()) tree_->expand(proxy_->mapFromSource(index));
 }
 
-void Widget::updateItemWidgets(QStandardItem* parent) const
+void Widget::updateItemWidgets(QStandardItem* parent, bool open) const
 {
 	for (auto t = 0; t < parent->rowCount();t++)
 	{
 		auto child = parent->child(t);
-		if (child->hasChildren()) updateItemWidgets(child);
+		if (child->hasChildren()) updateItemWidgets(child, open);
 		
-		auto keyframeChild = parent->child(t, static_cast<int>(Model::Columns::Item));
-		keyframer_->openPersistentEditor(proxy_->mapFromSource(keyframeChild->index()));
+		auto keyframeChild = proxy_->mapFromSource(parent->child(t, static_cast<int>(Model::Columns::Item))->index());
+		if (open) keyframer_->openPersistentEditor(keyframeChild);
+		else keyframer_->closePersistentEditor(keyframeChild);
 	}
 }
 
+void Widget::setVirtualizedKeyframer(bool virtualized)
+{
+	if (keyframer_->isVirtualized() == virtualized) return;
+
+	keyframer_->setVirtualized(virtualized);
+	updateItemWidgets(model_->invisibleRootItem(), !virtualized);
+}
+
 void Widget::syncVerticalScrollBars(int value) const
 {
 	if (tree_->verticalScrollBar()->value() != value) tree_->verticalScrollBar()->setValue(value);
@@ -20,13 +20,16 @@ public:
 
 	void mutate();
 
+	// Paints the keyframer rows instead of opening an editor widget per row
+	void setVirtualizedKeyframer(bool virtualized);
+
 	const Model& model() const { return *model_.get(); }
 
 public slots:
 	void projectMutated(std::shared_ptr<Core::MutationInfo> mutationInfo) const;
 
 private:
-	void updateItemWidgets(QStandardItem* parent) const;
+	void updateItemWidgets(QStandardItem* parent, bool open) const;
 	void syncVerticalScrollBars(int value) const;
 
 	Core::Project& project_;
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "static.h"
+
+#include <chrono>
+
+// Runs fn the given number of times and returns the average time per iteration in microseconds
+template <typename Fn>
+inline double measure(size_t iterations, Fn&& fn)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < iterations; i++) fn(i);
+	auto end = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double, std::micro>(end - start).count() / iterations;
+}
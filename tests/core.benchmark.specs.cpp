@@ -0,0 +1,693 @@
+#include "static.h"
+
+using namespace bandit;
+#include "test-utils.h"
+#include "testnode.h"
+#include "benchmark.h"
+#include <numeric>
+
+// The MutationInfo diff as it was before it used the document structure, to compare against
+struct ReferenceMutationInfo
+{
+	template <typename T>
+	using ChangeSet = MutationInfo::ChangeSet<T>;
+	template <typename T>
+	using Change = MutationInfo::Change<T>;
+	using ChangeType = MutationInfo::ChangeType;
+
+	ChangeSet<NodePtr> nodes;
+	ChangeSet<PropertyPtr> properties;
+	ChangeSet<ConnectorMetadataPtr> connectors;
+	ChangeSet<ConnectionPtr> connections;
+
+	ReferenceMutationInfo(const Document& prev, const Document& cur)
+	{
+		std::vector<NodePtr> prevNodes, curNodes;
+		for (auto&& node : prev.nodes()) if (node != prev.root()) prevNodes.emplace_back(node);
+		for (auto&& node : cur.nodes()) if (node != cur.root()) curNodes.emplace_back(node);
+
+		auto findNodeByUuid = [](const std::vector<NodePtr>& c, const Uuid& uuid)
+		{
+			auto it = find_if(cbegin(c), cend(c), [&](auto& node) { return node->uuid() == uuid; });
+			return it != cend(c) ? *it : nullptr;
+		};
+
+		for (auto&& prevNode : prevNodes)
+		{
+			if (findNodeByUuid(curNodes, prevNode->uuid())) continue;
+			nodes.emplace_back(Change<NodePtr>(prevNode, {}, ChangeType::Removed, prev.parent(*prevNode), {}, prev.childIndex(*prevNode), -1));
+		}
+
+		for (auto&& curNode : curNodes)
+		{
+			auto prevNode = findNodeByUuid(prevNodes, curNode->uuid());
+			if (!prevNode) nodes.emplace_back(Change<NodePtr>({}, curNode, ChangeType::Added, {}, cur.parent(*curNode), -1, cur.childIndex(*curNode)));
+			else if (prevNode != curNode || prev.parent(*prevNode) != cur.parent(*curNode) || prev.childIndex(*prevNode) != cur.childIndex(*curNode))
+			{
+				nodes.emplace_back(Change<NodePtr>(prevNode, curNode, ChangeType::Mutated, prev.parent(*prevNode), cur.parent(*curNode), prev.childIndex(*prevNode), cur.childIndex(*curNode)));
+			}
+		}
+
+		for (auto&& prevNode : prevNodes)
+		{
+			auto curNode = findNodeByUuid(curNodes, prevNode->uuid());
+			for (auto&& prevProp : prevNode->properties())
+			{
+				if (curNode && find_if(cbegin(curNode->properties()), cend(curNode->properties()), property_eq_hash(prevProp)) != cend(curNode->properties())) continue;
+				properties.emplace_back(Change<PropertyPtr>(prevProp, {}, ChangeType::Removed, prevNode, {}, prev.childIndex(*prevProp), -1));
+			}
+		}
+
+		for (auto&& curNode : curNodes)
+		{
+			auto prevNode = findNodeByUuid(prevNodes, curNode->uuid());
+			for (auto&& curProp : curNode->properties())
+			{
+				auto prevProp = prevNode ? find_if(cbegin(prevNode->properties()), cend(prevNode->properties()), property_eq_hash(curProp)) : cend(curNode->properties());
+				if (!prevNode || prevProp == cend(prevNode->properties())) properties.emplace_back(Change<PropertyPtr>({}, curProp, ChangeType::Added, {}, curNode, -1, cur.childIndex(*curProp)));
+				else if (*prevProp != curProp) properties.emplace_back(Change<PropertyPtr>(*prevProp, curProp, ChangeType::Mutated, prevNode, curNode, prev.childIndex(**prevProp), cur.childIndex(*curProp)));
+			}
+		}
+	}
+};
+
+static Document makeScene(size_t nodeCount, std::vector<NodePtr>& nodes)
+{
+	auto root = makeNode(hash("TestNode"), "root");
+	auto doc = Document::buildRootDocument(root);
+	Document::Builder b(doc);
+	addScene(b, nodeCount, nodes);
+	return Document(std::move(b));
+}
+
+// Saves the project with the given archive types and returns the time in microseconds it takes to load it back
+template <typename OutputArchive, typename InputArchive>
+static double measureLoad(const Project& p, std::string& contents)
+{
+	std::stringstream out(std::ios::out | std::ios::binary);
+	{
+		OutputArchive archive(out);
+		archive(p);
+	}
+	contents = out.str();
+
+	Project loaded;
+	auto time = measure(1, [&](size_t)
+	{
+		std::stringstream in(contents, std::ios::in | std::ios::binary);
+		InputArchive archive(in);
+		archive(loaded);
+	});
+
+	AssertThat(loaded.current().nodes().size(), Equals(p.current().nodes().size()));
+	return time;
+}
+
+// A double property with keys at every tenth frame
+static Property makeAnimatedProperty(size_t keyCount)
+{
+	auto node = makeNode(hash("TestNode"), "node");
+	Property::Builder b(*prop(*node, "double"));
+	for (size_t i = 0; i < keyCount; i++) b.set(static_cast<Frame>(i * 10), static_cast<double>(i % 7));
+	return Property(std::move(b));
+}
+
+go_bandit([]() {
+	describe("document lookup benchmark:", []()
+	{
+		it("performs node lookups without scanning the scene", [&]()
+		{
+			const size_t iterations = 1000;
+
+			for (size_t nodeCount : { 1000, 10000, 100000 })
+			{
+				std::vector<NodePtr> nodes;
+				auto doc = makeScene(nodeCount, nodes);
+
+				size_t found = 0;
+				auto time = measure(iterations, [&](size_t i)
+				{
+					auto& node = nodes[(i * 7919) % nodes.size()];
+					if (doc.exists(*node)) found++;
+					if (doc.parent(*node)) found++;
+					if (doc.find(node->uuid()) == node) found++;
+					found += doc.childIndex(*node) < 100;
+				});
+				AssertThat(found, Equals(iterations * 4));
+
+				// Reference: a single scan over the tree, which is what every lookup used to cost
+				auto scan = measure(10, [&](size_t i)
+				{
+					auto& node = nodes[(i * 7919) % nodes.size()];
+					found += std::find(cbegin(doc.nodes()), cend(doc.nodes()), node) != cend(doc.nodes());
+				});
+
+				LOG->info("Document lookups with {} nodes: {:.3f} us, linear scan: {:.3f} us", nodeCount, time, scan);
+				if (nodeCount >= 10000) AssertThat(time * 10, IsLessThan(scan));
+			}
+		});
+	});
+
+	describe("document mutation benchmark:", []()
+	{
+		it("mutates a single node without copying the scene", [&]()
+		{
+			const size_t iterations = 200;
+			std::vector<double> timings;
+
+			for (size_t nodeCount : { 1000, 100000 })
+			{
+				Project p;
+				std::vector<NodePtr> nodes;
+				p.mutate([&](auto& b) { addScene(b, nodeCount, nodes); });
+
+				auto time = measure(iterations, [&](size_t i)
+				{
+					auto node = p.current().find(nodes[(i * 7919) % nodes.size()]->uuid());
+					p.mutate([&](Document::Builder& mut)
+					{
+						mut.mutate(node, [&](Node::Builder& n)
+						{
+							n.mutateProperty(hash("double"), [&](Property::Builder& prop) { prop.set(0, static_cast<double>(i)); });
+						});
+					});
+				});
+
+				LOG->info("Single node mutation with {} nodes: {:.3f} us", nodeCount, time);
+				timings.push_back(time);
+			}
+
+			// Copying the scene would make this 100x slower on the larger scene
+			AssertThat(timings.back(), IsLessThan(timings.front() * 10));
+		});
+
+		it("inserts into and indexes a wide parent without copying its children", [&]()
+		{
+			std::vector<double> timings;
+
+			for (size_t childCount : { 2000, 32000 })
+			{
+				Project p;
+				NodePtr first;
+				p.mutate([&](auto& b) { b.append({ first = makeNode(hash("TestNode"), "node") }); });
+
+				// Every insert lands in front of all earlier ones, which is the worst case for a flat child list
+				std::vector<NodePtr> nodes;
+				auto time = measure(childCount, [&](size_t)
+				{
+					auto node = makeNode(hash("TestNode"), "node");
+					p.mutate([&](auto& b) { b.insertBefore(nodes.empty() ? first : nodes.back(), { node }); });
+					nodes.push_back(node);
+				});
+
+				size_t found = 0;
+				time += measure(childCount, [&](size_t i) { found += p.current().childIndex(*nodes[i]) == childCount - i - 1; });
+				AssertThat(found, Equals(childCount));
+
+				LOG->info("Inserting into and indexing a parent with {} children: {:.3f} us", childCount, time);
+				timings.push_back(time);
+			}
+
+			// Copying the child list would make this 16x slower per child on the wider parent
+			AssertThat(timings.back(), IsLessThan(timings.front() * 8));
+		});
+	});
+
+	describe("mutation info benchmark:", []()
+	{
+		it("only looks at the nodes that changed", [&]()
+		{
+			for (size_t nodeCount : { 2000, 20000 })
+			{
+				Project p;
+				std::vector<NodePtr> nodes;
+				p.mutate([&](auto& b) { addScene(b, nodeCount, nodes); });
+
+				auto prev = p.current();
+				auto node = p.current().find(nodes[nodeCount / 2]->uuid());
+				p.mutate([&](Document::Builder& mut)
+				{
+					mut.mutate(node, [&](Node::Builder& n)
+					{
+						n.mutateProperty(hash("double"), [&](Property::Builder& prop) { prop.set(0, 1.0); });
+					});
+					mut.erase({ nodes[nodeCount / 4] });
+					mut.append({ makeNode(hash("TestNode"), "added") });
+				});
+
+				std::shared_ptr<MutationInfo> mutation;
+				auto time = measure(1, [&](size_t) { mutation = std::make_shared<MutationInfo>(prev, p.current()); });
+
+				std::shared_ptr<ReferenceMutationInfo> reference;
+				auto referenceTime = measure(1, [&](size_t) { reference = std::make_shared<ReferenceMutationInfo>(prev, p.current()); });
+
+				AssertThat(mutation->nodes, Equals(reference->nodes));
+				AssertThat(mutation->properties, Equals(reference->properties));
+
+				LOG->info("Mutation info with {} nodes: {:.3f} us, previous implementation: {:.3f} us", nodeCount, time, referenceTime);
+				AssertThat(time * 10, IsLessThan(referenceTime));
+			}
+		});
+
+		it("notifies about a single node mutation independent of the scene size", [&]()
+		{
+			const size_t iterations = 200;
+			std::vector<double> timings;
+
+			for (size_t nodeCount : { 1000, 100000 })
+			{
+				Project p;
+				std::vector<NodePtr> nodes;
+				p.mutate([&](auto& b) { addScene(b, nodeCount, nodes); });
+
+				size_t changes = 0;
+				p.setMutationCallback([&](auto mutation) { changes += mutation->properties.size(); });
+
+				auto time = measure(iterations, [&](size_t i)
+				{
+					auto node = p.current().find(nodes[(i * 7919) % nodes.size()]->uuid());
+					p.mutate([&](Document::Builder& mut)
+					{
+						mut.mutate(node, [&](Node::Builder& n)
+						{
+							n.mutateProperty(hash("double"), [&](Property::Builder& prop) { prop.set(0, static_cast<double>(i + 1)); });
+						});
+					});
+				});
+				AssertThat(changes, Equals(iterations));
+
+				LOG->info("Single node mutation and notification with {} nodes: {:.3f} us", nodeCount, time);
+				timings.push_back(time);
+			}
+
+			AssertThat(timings.back(), IsLessThan(timings.front() * 10));
+		});
+	});
+
+	describe("serialization benchmark:", []()
+	{
+		it("loads binary projects faster than json and stores them smaller", [&]()
+		{
+			const size_t nodeCount = 50000;
+
+			Project p;
+			std::vector<NodePtr> nodes;
+			p.mutate([&](auto& b) { addScene(b, nodeCount, nodes); });
+
+			std::string json, binary;
+			auto jsonTime = measureLoad<cereal::JSONOutputArchive, cereal::JSONInputArchive>(p, json);
+			auto binaryTime = measureLoad<cereal::PortableBinaryOutputArchive, cereal::PortableBinaryInputArchive>(p, binary);
+
+			LOG->info("Loading {} nodes from json: {:.3f} ms, {} bytes", nodeCount, jsonTime / 1000, json.size());
+			LOG->info("Loading {} nodes from binary: {:.3f} ms, {} bytes", nodeCount, binaryTime / 1000, binary.size());
+
+			AssertThat(binary.size(), IsLessThan(json.size()));
+			AssertThat(binaryTime, IsLessThan(jsonTime));
+		});
+
+		it("loads a project in time linear to its size", [&]()
+		{
+			std::vector<double> timings;
+
+			for (size_t nodeCount : { 5000, 50000 })
+			{
+				// All nodes directly under the root, so inserting them one at a time would copy an ever growing child list
+				Project p;
+				p.mutate([&](Document::Builder& b)
+				{
+					for (size_t i = 0; i < nodeCount; i++) b.append({ makeNode(hash("TestNode"), "node") });
+				});
+
+				std::string binary;
+				auto time = measureLoad<cereal::PortableBinaryOutputArchive, cereal::PortableBinaryInputArchive>(p, binary);
+
+				LOG->info("Loading {} nodes below the root: {:.3f} ms", nodeCount, time / 1000);
+				timings.push_back(time);
+			}
+
+			// A quadratic load would take 100x as long for 10x the nodes
+			AssertThat(timings.back(), IsLessThan(timings.front() * 30));
+		});
+	});
+
+	describe("property sampling benchmark:", []()
+	{
+		it("samples in time logarithmic to the number of keys", [&]()
+		{
+			const size_t iterations = 100000;
+			std::vector<double> timings;
+
+			for (size_t keyCount : { 10, 100, 1000, 10000, 100000 })
+			{
+				auto property = makeAnimatedProperty(keyCount);
+				auto length = static_cast<Frame>(keyCount * 10);
+
+				double sum = 0;
+				auto time = measure(iterations, [&](size_t i)
+				{
+					sum += property.get<double>(static_cast<Frame>((i * 7919) % static_cast<size_t>(length)) + 0.5f);
+				});
+				AssertThat(property.keys().size(), Equals(keyCount));
+
+				LOG->info("Sampling a property with {} keys: {:.4f} us (checksum {})", keyCount, time, sum);
+				timings.push_back(time);
+			}
+
+			AssertThat(timings.back(), IsLessThan(timings.front() * 10));
+		});
+
+		it("scrubs through a property about as fast as it looks up keys", [&]()
+		{
+			const size_t keyCount = 1000;
+			const size_t iterations = 100000;
+			auto property = makeAnimatedProperty(keyCount);
+
+			double sum = 0;
+			auto keyTime = measure(iterations, [&](size_t i) { sum += property.get<double>(static_cast<Frame>((i % keyCount) * 10)); });
+
+			// Dense scrubbing keeps hitting the same few segments, which only need their cached coefficients evaluated
+			auto scrubTime = measure(iterations, [&](size_t i) { sum += property.get<double>(static_cast<Frame>(i) * 0.01f); });
+
+			LOG->info("Sampling {} keys: {:.4f} us, scrubbing between them: {:.4f} us (checksum {})", keyCount, keyTime, scrubTime, sum);
+			AssertThat(scrubTime, IsLessThan(keyTime * 2));
+		});
+
+		it("samples typed keys at least as fast as through the variant", [&]()
+		{
+			const size_t keyCount = 1000;
+			const size_t iterations = 100000;
+			auto property = makeAnimatedProperty(keyCount);
+
+			double sum = 0;
+			auto typedTime = measure(iterations, [&](size_t i) { sum += property.get<double>(static_cast<Frame>(i) * 0.05f); });
+			auto variantTime = measure(iterations, [&](size_t i) { sum += *property.getPropertyValue(static_cast<Frame>(i) * 0.05f).target<double>(); });
+
+			LOG->info("Bytes per double key: {}, stored as a variant: {}", sizeof(Frame) + sizeof(double), sizeof(Frame) + sizeof(PropertyValue));
+			LOG->info("Sampling typed keys: {:.4f} us, through the variant: {:.4f} us (checksum {})", typedTime, variantTime, sum);
+			AssertThat(sizeof(double), IsLessThan(sizeof(PropertyValue)));
+
+			// Leave some room for timing noise, the difference is mostly the variant copy
+			AssertThat(typedTime, IsLessThan(variantTime * 1.5));
+		});
+
+		it("samples a range of frames faster than one frame at a time", [&]()
+		{
+			const size_t keyCount = 1000;
+			const size_t frameCount = 100000;
+			auto property = makeAnimatedProperty(keyCount);
+			auto step = static_cast<Frame>(keyCount * 10) / frameCount;
+
+			std::vector<double> single(frameCount), batch(frameCount);
+			auto singleTime = measure(1, [&](size_t)
+			{
+				for (size_t i = 0; i < frameCount; i++) single[i] = property.get<double>(step * static_cast<Frame>(i));
+			});
+			auto batchTime = measure(1, [&](size_t) { property.sampleRange(0, step, frameCount, batch.data()); });
+
+			for (size_t i = 0; i < frameCount; i++) AssertThat(batch[i], EqualsWithDelta(single[i], 1e-3));
+
+			LOG->info("Sampling {} frames one at a time: {:.3f} us, as a range: {:.3f} us", frameCount, singleTime, batchTime);
+			AssertThat(batchTime, IsLessThan(singleTime));
+		});
+	});
+
+	describe("property interning benchmark:", []()
+	{
+		it("interns properties that only differ by value in time independent of their number", [&]()
+		{
+			std::vector<double> timings;
+			auto node = makeNode(hash("TestNode"), "node");
+
+			for (size_t propertyCount : { 2000, 32000 })
+			{
+				// Keeping them alive keeps them in the intern table, and they all have their only key at frame 0
+				std::vector<Property> properties;
+				properties.reserve(propertyCount);
+				auto time = measure(propertyCount, [&](size_t i)
+				{
+					Property::Builder b(*prop(*node, "double"));
+					b.set(0, static_cast<double>(i));
+					properties.emplace_back(std::move(b));
+				});
+				AssertThat(properties.back().get<double>(0), Equals(static_cast<double>(propertyCount - 1)));
+
+				LOG->info("Interning {} properties with distinct values: {:.3f} us", propertyCount, time);
+				timings.push_back(time);
+			}
+
+			// Comparing against every property with the same frames would make this 16x slower per property
+			AssertThat(timings.back(), IsLessThan(timings.front() * 8));
+		});
+	});
+
+	describe("scene evaluation benchmark:", []()
+	{
+		it("scales evaluation of a scene with the number of threads", [&]()
+		{
+			const size_t nodeCount = 2000;
+			const size_t frameCount = 1000;
+
+			Project p;
+			std::vector<NodePtr> nodes;
+			p.mutate([&](Document::Builder& b) { addScene(b, nodeCount, nodes); });
+			p.mutate([&](Document::Builder& b) { for (auto&& node : nodes) TestNode::addKeyframes(b, node); });
+
+			ThreadPool serialPool(1);
+			ThreadPool parallelPool;
+
+			auto serialTime = measure(1, [&](size_t) { SceneEvaluator evaluator(p.current(), 0, 0.1f, frameCount, serialPool); });
+			auto parallelTime = measure(1, [&](size_t) { SceneEvaluator evaluator(p.current(), 0, 0.1f, frameCount, parallelPool); });
+
+			LOG->info("Evaluating {} nodes over {} frames on 1 thread: {:.3f} us, on {} threads: {:.3f} us",
+				nodeCount, frameCount, serialTime, parallelPool.threadCount(), parallelTime);
+
+			// Only hold the evaluator to a speedup where there are cores to spread the work over
+			if (parallelPool.threadCount() > 1) AssertThat(parallelTime, IsLessThan(serialTime));
+		});
+	});
+
+	describe("visibility benchmark:", []()
+	{
+		it("finds active nodes faster than scanning the tree", [&]()
+		{
+			const size_t iterations = 1000;
+
+			for (size_t nodeCount : { 5000, 50000 })
+			{
+				Project p;
+				std::vector<NodePtr> nodes;
+				p.mutate([&](Document::Builder& b) { addScene(b, nodeCount, nodes); });
+
+				// Short clips spread over the timeline, so only a few are active at any frame
+				p.mutate([&](Document::Builder& b)
+				{
+					for (size_t i = 0; i < nodes.size(); i++)
+					{
+						auto start = static_cast<Frame>((i * 7919) % 100000);
+						b.mutate(nodes[i], [&](Node::Builder& node) { node.mutateVisibility({ start, start + 50 }); });
+					}
+				});
+
+				auto& document = p.current();
+				size_t found = 0;
+				auto time = measure(iterations, [&](size_t i) { found += document.activeNodes(static_cast<Frame>(i * 97 % 100000)).size(); });
+				auto rangeTime = measure(iterations, [&](size_t i)
+				{
+					auto start = static_cast<Frame>(i * 97 % 100000);
+					found += document.activeNodes(start, start + 100).size();
+				});
+
+				size_t scanned = 0;
+				auto scan = measure(10, [&](size_t i)
+				{
+					auto frame = static_cast<Frame>(i * 97 % 100000);
+					for (auto&& node : document.nodes())
+					{
+						if (node->visibility().first <= frame && frame < node->visibility().second) scanned++;
+					}
+				});
+
+				// Moving a single clip only touches its path through the index
+				auto mutation = measure(100, [&](size_t i)
+				{
+					p.mutate([&](Document::Builder& b)
+					{
+						auto node = document.find(nodes[i]->uuid());
+						b.mutate(node, [&](Node::Builder& n) { n.mutateVisibility({ static_cast<Frame>(i), static_cast<Frame>(i + 50) }); });
+					});
+				});
+
+				LOG->info("Active nodes with {} nodes: {:.3f} us, in a range: {:.3f} us, tree scan: {:.3f} us, moving a clip: {:.3f} us (found {}, {})",
+					nodeCount, time, rangeTime, scan, mutation, found, scanned);
+				AssertThat(time * 10, IsLessThan(scan));
+			}
+		});
+	});
+
+	describe("allocation benchmark:", []()
+	{
+		it("allocates shared objects from the pool faster than from the heap", [&]()
+		{
+			const size_t iterations = 200000;
+			struct Payload { char bytes[120]; };
+
+			// Keep a window of objects alive, like the few document versions the history holds on to
+			std::vector<std::shared_ptr<Payload>> window(1000);
+			auto heapTime = measure(iterations, [&](size_t i) { window[i % window.size()] = std::make_shared<Payload>(); });
+			auto poolTime = measure(iterations, [&](size_t i) { window[i % window.size()] = makePooled<Payload>(); });
+
+			LOG->info("Allocating shared objects from the heap: {:.4f} us, from the pool: {:.4f} us", heapTime, poolTime);
+			AssertThat(poolTime, IsLessThan(heapTime));
+		});
+	});
+
+	describe("connection benchmark:", []()
+	{
+		it("fixes up connections in time independent of their number", [&]()
+		{
+			const size_t iterations = 100;
+			std::vector<double> timings;
+
+			for (size_t connectionCount : { 1000, 10000 })
+			{
+				Project p;
+				std::vector<NodePtr> nodes;
+				p.mutate([&](Document::Builder& b) { addScene(b, connectionCount + 1, nodes); });
+
+				// A chain of connected nodes, with the last node left unconnected
+				p.mutate([&](Document::Builder& b)
+				{
+					for (size_t i = 0; i + 2 < nodes.size(); i++)
+					{
+						b.connect(std::make_shared<Connection>(make_tuple(nodes[i], connector(*nodes[i], "Out"), nodes[i + 1], connector(*nodes[i + 1], "In"))));
+					}
+				});
+				AssertThat(p.current().connections().size(), Equals(connectionCount - 1));
+
+				auto mutate = [&](size_t index, size_t i)
+				{
+					auto node = p.current().find(nodes[index]->uuid());
+					p.mutate([&](Document::Builder& b)
+					{
+						b.mutate(node, [&](Node::Builder& n) { n.mutateVisibility({ 0, static_cast<Frame>(i) }); });
+					});
+				};
+
+				// Changing a node only looks at the connections of that node. Fixing those up still copies the list of
+				// all connections once, so only the unconnected case is independent of the number of connections.
+				auto time = measure(iterations, [&](size_t i) { mutate(nodes.size() - 1, i); });
+				auto connectedTime = measure(iterations, [&](size_t i) { mutate(connectionCount / 2, i); });
+
+				auto middle = p.current().find(nodes[connectionCount / 2]->uuid());
+				AssertThat(p.current().inputConnections(*middle).size(), Equals(1));
+				AssertThat(p.current().outputConnections(*middle)[0]->outputNode() == middle, Equals(true));
+
+				LOG->info("Mutating a node with {} connections in the document: {:.3f} us, a connected node: {:.3f} us", connectionCount, time, connectedTime);
+				timings.push_back(time);
+			}
+
+			AssertThat(timings.back(), IsLessThan(timings.front() * 3));
+		});
+	});
+
+	describe("graph scheduling benchmark:", []()
+	{
+		it("schedules a graph in a few passes over its nodes and connections", [&]()
+		{
+			const size_t layerSize = 100;
+
+			for (size_t nodeCount : { 1000, 10000 })
+			{
+				Project p;
+				std::vector<NodePtr> nodes;
+				p.mutate([&](Document::Builder& b) { addScene(b, nodeCount, nodes); });
+
+				// Layers of nodes that each feed two nodes of the next layer
+				p.mutate([&](Document::Builder& b)
+				{
+					for (size_t i = 0; i + layerSize < nodes.size(); i++)
+					{
+						for (auto j : { i + layerSize, i + layerSize - i % 2 })
+						{
+							b.connect(std::make_shared<Connection>(make_tuple(nodes[i], connector(*nodes[i], "Out"), nodes[j], connector(*nodes[j], "In"))));
+						}
+					}
+				});
+
+				auto& document = p.current();
+				size_t waveCount = 0;
+				auto time = measure(10, [&](size_t) { waveCount = GraphScheduler(document).waves().size(); });
+				AssertThat(waveCount, IsGreaterThan(nodeCount / layerSize - 1));
+
+				// Visiting every node and its connections once is the least any schedule has to do
+				size_t connectionCount = 0;
+				auto visitTime = measure(10, [&](size_t)
+				{
+					for (auto&& node : document.nodes()) connectionCount += document.outputConnections(*node).size();
+				});
+
+				LOG->info("Scheduling {} nodes in {} waves: {:.3f} us, visiting them: {:.3f} us", nodeCount, waveCount, time, visitTime);
+				AssertThat(time, IsLessThan(visitTime * 10));
+			}
+		});
+	});
+
+	describe("evaluation cache benchmark:", []()
+	{
+		it("re-evaluates only the nodes downstream of an edit", [&]()
+		{
+			const size_t nodeCount = 5000;
+			const size_t chainLength = 10;
+
+			Project p;
+			std::vector<NodePtr> nodes;
+			p.mutate([&](Document::Builder& b) { addScene(b, nodeCount, nodes); });
+			p.mutate([&](Document::Builder& b) { for (auto&& node : nodes) TestNode::addKeyframes(b, node); });
+
+			// Independent chains of connected nodes
+			p.mutate([&](Document::Builder& b)
+			{
+				for (size_t i = 0; i + 1 < nodes.size(); i++)
+				{
+					if ((i + 1) % chainLength == 0) continue;
+					auto from = p.current().find(nodes[i]->uuid()), to = p.current().find(nodes[i + 1]->uuid());
+					b.connect(std::make_shared<Connection>(make_tuple(from, connector(*from, "Out"), to, connector(*to, "In"))));
+				}
+			});
+
+			EvaluationCache<double> cache;
+			std::function<double(const NodePtr&, Frame)> evaluate = [&](const NodePtr& node, Frame frame)
+			{
+				double samples[100];
+				prop(*node, "double")->sampleRange(frame, 1, 100, samples);
+				auto result = std::accumulate(std::begin(samples), std::end(samples), 0.0);
+				for (auto&& connection : p.current().inputConnections(*node)) result += cache.get(connection->outputNode(), frame, evaluate);
+				return result;
+			};
+
+			ThreadPool pool;
+			auto evaluateAll = [&]()
+			{
+				GraphScheduler(p.current()).run(pool, [&](const NodePtr& node) { if (node != p.current().root()) cache.get(node, 0, evaluate); });
+			};
+
+			p.setMutationCallback([&](auto mutation) { cache.invalidate(*mutation); });
+			auto coldTime = measure(1, [&](size_t) { evaluateAll(); });
+			auto coldMisses = cache.misses();
+
+			// Edit the first node of a chain, so the whole chain is stale
+			cache.resetCounters();
+			auto edited = p.current().find(nodes[chainLength * 7]->uuid());
+			p.mutate([&](Document::Builder& b)
+			{
+				b.mutate(edited, [&](Node::Builder& node) { node.mutateProperty(hash("double"), [&](Property::Builder& prop) { prop.set(50, 1.0); }); });
+			});
+			auto editTime = measure(1, [&](size_t) { evaluateAll(); });
+
+			LOG->info("Evaluating {} nodes: {:.3f} us, {} misses; after an edit: {:.3f} us, {} misses, {} hits",
+				nodes.size(), coldTime, coldMisses, editTime, cache.misses(), cache.hits());
+			AssertThat(cache.misses(), Equals(chainLength));
+			AssertThat(editTime, IsLessThan(coldTime));
+		});
+	});
+});
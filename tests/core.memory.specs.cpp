@@ -0,0 +1,72 @@
+#include "static.h"
+
+using namespace bandit;
+#include "test-utils.h"
+#include "testnode.h"
+#include "memory_tracker.h"
+
+// Only allocation counts, so unlike the benchmarks these don't depend on the speed of the machine
+go_bandit([]() {
+	describe("memory:", []()
+	{
+		it("mutates documents without growing the pools", [&]()
+		{
+			const size_t nodeCount = 2000;
+			const size_t generations = 100;
+
+			Project p;
+			std::vector<NodePtr> nodes;
+			p.mutate([&](Document::Builder& b) { addScene(b, nodeCount, nodes); });
+
+			// Keep next to no history, so every generation frees about as much as it allocates
+			p.setHistorySettings({ Project::HistoryMode::Deltas, 4, 1 });
+
+			size_t reserved = 0;
+			for (size_t i = 0; i < generations; i++)
+			{
+				// Every generation replaces a tenth of the nodes and properties
+				p.mutate([&](Document::Builder& b)
+				{
+					for (size_t n = i % 10; n < nodes.size(); n += 10)
+					{
+						auto node = p.current().find(nodes[n]->uuid());
+						b.mutate(node, [&](Node::Builder& mut)
+						{
+							mut.mutateProperty(hash("double"), [&](Property::Builder& prop) { prop.set(0, static_cast<double>(i)); });
+						});
+					}
+				});
+
+				if (i == generations / 10) reserved = Pool::reservedBytes();
+			}
+
+			// Freed blocks are reused, so the pools stop growing once they hold the working set
+			AssertThat(Pool::reservedBytes(), IsLessThan(reserved * 3 / 2));
+		});
+
+		it("shares the data of default properties between nodes", [&]()
+		{
+			const size_t nodeCount = 10000;
+
+			// Builds the scene and returns the heap memory it takes up
+			auto sceneBytes = [&]()
+			{
+				auto before = MemoryTracker::current();
+				auto p = std::make_unique<Project>();
+				std::vector<NodePtr> nodes;
+				p->mutate([&](Document::Builder& b) { addScene(b, nodeCount, nodes); });
+				auto bytes = MemoryTracker::current() - before;
+				nodes.clear();
+				p.reset();
+				return bytes;
+			};
+
+			// Pool chunks freed by the first scene are reused by the second one, which only works against interning
+			auto interned = sceneBytes();
+			Property::setInterning(false);
+			auto separate = sceneBytes();
+			Property::setInterning(true);
+			AssertThat(interned, IsLessThan(separate));
+		});
+	});
+});
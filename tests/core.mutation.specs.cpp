@@ -13,13 +13,19 @@ go_bandit([]() {
 	{
 		std::unique_ptr<MutationProject> p;
 		std::vector<std::shared_ptr<MutationInfo>> mutations;
+		std::vector<std::shared_ptr<MutationInfo>> diffedMutations;
 
 		before_each([&]()
 		{
 			mutations.clear();
+			diffedMutations.clear();
 
 			p = std::make_unique<MutationProject>();
-			p->setMutationCallback([&mutations](auto mutationInfo) { mutations.emplace_back(mutationInfo); });
+			p->setMutationCallback([&](auto mutationInfo)
+			{
+				mutations.emplace_back(mutationInfo);
+				diffedMutations.emplace_back(std::make_shared<MutationInfo>(mutationInfo->prev, mutationInfo->cur));
+			});
 
 			p->applyMutationsTo(MutationProject::NUM_MUTATIONS - 1);
 		});
@@ -29,6 +35,18 @@ go_bandit([]() {
 			AssertThat(mutations.size(), !Equals(0));
 		});
 
+		it("should emit the same changes from the builder journal as from comparing documents", [&]()
+		{
+			for (size_t i = 0; i < mutations.size(); i++)
+			{
+				AssertThat(mutations[i]->nodes, Equals(diffedMutations[i]->nodes));
+				AssertThat(mutations[i]->properties, Equals(diffedMutations[i]->properties));
+				AssertThat(mutations[i]->connectors, Equals(diffedMutations[i]->connectors));
+				AssertThat(mutations[i]->connections.size(), Equals(diffedMutations[i]->connections.size()));
+				for (auto&& c : diffedMutations[i]->connections) AssertThat(mutations[i]->connections, Contains(c));
+			}
+		});
+
 		it("should emit added nodes", [&]()
 		{
 			auto mutation = mutations.at(0);
@@ -103,6 +121,27 @@ go_bandit([]() {
 			AssertThat(mutation->connections.begin()->prev->connection(), Equals(make_tuple(p->a[6], connector(*p->a[6], "Out"), p->b[6], connector(*p->b[6], "In"))));
 		});
 
+		it("should cancel connections that were removed and added again", [&]()
+		{
+			auto a = makeNode(hash("TestNode"), "x"), b = makeNode(hash("TestNode"), "y");
+			auto connection = std::make_shared<Connection>(make_tuple(a, connector(*a, "Out"), b, connector(*b, "In")));
+			p->mutate({
+				[&](Document::Builder& mut) { mut.append({ a, b }); },
+				[&](Document::Builder& mut) { mut.connect(connection); }
+			});
+
+			// Erasing b takes the connection with it, and putting both back leaves the document as it was
+			p->mutate({
+				[&](Document::Builder& mut) { mut.erase({ b }); },
+				[&](Document::Builder& mut) { mut.append({ b }); mut.connect(connection); }
+			});
+
+			AssertThat(diffedMutations.back()->nodes.size(), Equals(0));
+			AssertThat(diffedMutations.back()->connections.size(), Equals(0));
+			AssertThat(mutations.back()->nodes, Equals(diffedMutations.back()->nodes));
+			AssertThat(mutations.back()->connections.size(), Equals(0));
+		});
+
 		it("should emit reparenting from root to lower", [&]()
 		{
 			auto mutation = mutations.at(8);
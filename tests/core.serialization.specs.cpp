@@ -43,20 +43,8 @@ go_bandit([]() {
 
 		});
 
-		it("should serialize and deserialize", [&]()
+		auto assertDeserialized = [&]()
 		{
-			std::stringstream s;
-			{
-				cereal::JSONOutputArchive archive(s);
-				archive(*p);
-			}
-
-			p2 = std::make_unique<Project>();
-			{
-				cereal::JSONInputArchive archive(s);
-				archive(*p2);
-			}
-
 			auto node_a = findNode(*p2, "a");
 			auto node_b = findNode(*p2, "b");
 			auto node_c = findNode(*p2, "c");
@@ -74,6 +62,77 @@ go_bandit([]() {
 			AssertThat(connector(*node_c, "Test") == nullptr, Equals(false));
 
 			TestNode::assertKeyframes(node_a);
+			AssertThat(p2->current().activeNodes(500).size(), Equals(3));
+		};
+
+		it("should serialize and deserialize", [&]()
+		{
+			std::stringstream s;
+			{
+				cereal::JSONOutputArchive archive(s);
+				archive(*p);
+			}
+
+			p2 = std::make_unique<Project>();
+			{
+				cereal::JSONInputArchive archive(s);
+				archive(*p2);
+			}
+
+			assertDeserialized();
+		});
+
+		it("should serialize and deserialize in the binary format", [&]()
+		{
+			std::stringstream s(std::ios::in | std::ios::out | std::ios::binary);
+			{
+				cereal::PortableBinaryOutputArchive archive(s);
+				archive(*p);
+			}
+
+			p2 = std::make_unique<Project>();
+			{
+				cereal::PortableBinaryInputArchive archive(s);
+				archive(*p2);
+			}
+
+			assertDeserialized();
+		});
+
+		it("should connect to the local connectors of the loaded nodes", [&]()
+		{
+			// A second node with the same local connector, so the loaded connectors can't be told apart by their data
+			p->mutate([&](auto& mut) { mut.append({ makeNode(hash("TestNode"), "d") }); });
+			p->mutate([&](Document::Builder& mut)
+			{
+				auto node_c = findNode(*p, "c");
+				auto node_d = findNode(*p, "d");
+				mut.mutate(node_d, [&](Node::Builder& node) { node.addConnector(ConnectorMetadata::Builder("Test", ConnectorType::Output)); });
+				mut.connect(std::make_shared<Connection>(make_tuple(node_c, connector(*node_c, "Test"), node_d, connector(*node_d, "In"))));
+			});
+
+			std::stringstream s(std::ios::in | std::ios::out | std::ios::binary);
+			{
+				cereal::PortableBinaryOutputArchive archive(s);
+				archive(*p);
+			}
+
+			p2 = std::make_unique<Project>();
+			{
+				cereal::PortableBinaryInputArchive archive(s);
+				archive(*p2);
+			}
+
+			auto node_c = findNode(*p2, "c");
+			auto node_d = findNode(*p2, "d");
+			AssertThat(p2->current().connections().size(), Equals(2));
+			for (auto&& c : p2->current().connections())
+			{
+				if (c->outputNode() != node_c) continue;
+				AssertThat(c->output() == connector(*node_c, "Test"), Equals(true));
+				AssertThat(c->output() == connector(*node_d, "Test"), Equals(false));
+				AssertThat(p2->current().parent(*c->output()) == node_c, Equals(true));
+			}
 		});
 	});
 });
\ No newline at end of file
@@ -65,6 +65,26 @@ go_bandit([]() {
 			AssertThat(p->current().totalChildCount(*p->root()), Equals(4));
 		});
 
+		it("can find nodes by uuid", [&]()
+		{
+			p->mutate([](auto& mut) { mut.append({ makeNode(hash("TestNode"), "g1") }); });
+			auto g1 = findNode(*p, "g1");
+			p->mutate([&](auto& mut) { mut.append(g1, { makeNode(hash("TestNode"), "a") }); });
+			auto a = findNode(*p, "a");
+			AssertThat(p->current().find(g1->uuid()), Equals(g1));
+			AssertThat(p->current().find(a->uuid()), Equals(a));
+
+			p->mutate([&](auto& mut) { mut.erase({ g1 }); });
+			AssertThat(p->current().find(g1->uuid()) == nullptr, Equals(true));
+			AssertThat(p->current().find(a->uuid()) == nullptr, Equals(true));
+			AssertThat(p->current().exists(*a), Equals(false));
+
+			p->undo();
+			AssertThat(p->current().find(a->uuid()), Equals(a));
+			AssertThat(p->current().exists(*a), Equals(true));
+			AssertThat(p->current().parent(*a), Equals(g1));
+		});
+
 		it("can reset", [&]()
 		{
 			const int NUM_ITERATIONS = 10;
@@ -77,6 +97,75 @@ go_bandit([]() {
 			for (int t = 0; t < NUM_ITERATIONS; t++) p->mutate([](auto& mut) { mut.append({ makeNode(hash("TestNode"), "a") }); });
 			AssertThat(p->current().totalChildCount(*p->root()), Equals(NUM_ITERATIONS));
 		});
+
+		it("keeps the order of many siblings", [&]()
+		{
+			std::vector<NodePtr> expected;
+			auto check = [&]()
+			{
+				auto& doc = p->current();
+				AssertThat(doc.childCount(*p->root()), Equals(expected.size()));
+				for (size_t i = 0; i < expected.size(); i++)
+				{
+					AssertThat(doc.child(*p->root(), i), Equals(expected[i]));
+					AssertThat(doc.childIndex(*expected[i]), Equals(i));
+				}
+			};
+
+			p->mutate([&](auto& mut)
+			{
+				for (int i = 0; i < 100; i++)
+				{
+					expected.push_back(makeNode(hash("TestNode"), "a"));
+					mut.append({ expected.back() });
+				}
+			});
+			check();
+			auto appended = expected;
+
+			// Inserting before the same node keeps halving the gap in front of it, until its neighbours get new positions
+			p->mutate([&](auto& mut)
+			{
+				auto before = expected[50];
+				for (int i = 0; i < 200; i++)
+				{
+					auto node = makeNode(hash("TestNode"), "b");
+					mut.insertBefore(before, { node });
+					expected.insert(std::find(begin(expected), end(expected), before), node);
+				}
+			});
+			check();
+
+			auto group = makeNode(hash("TestNode"), "g");
+			p->mutate([&](auto& mut)
+			{
+				for (int i = 0; i < 100; i++)
+				{
+					auto node = expected[(i * 7919) % expected.size()];
+					auto after = expected[(i * 104729) % expected.size()];
+					if (node == after) continue;
+
+					mut.moveAfter(after, { node });
+					expected.erase(std::find(begin(expected), end(expected), node));
+					expected.insert(std::next(std::find(begin(expected), end(expected), after)), node);
+				}
+
+				mut.append({ group });
+				mut.reparent(group, { expected[10] });
+				mut.erase({ expected[20], expected[200] });
+				expected.erase(begin(expected) + 200);
+				expected.erase(begin(expected) + 20);
+				expected.erase(begin(expected) + 10);
+				expected.push_back(group);
+			});
+			check();
+			AssertThat(p->current().childCount(*group), Equals(1));
+
+			p->undo();
+			p->undo();
+			expected = appended;
+			check();
+		});
 	});
 
 	describe("node:", []()
@@ -128,6 +217,72 @@ go_bandit([]() {
 			TestNode::assertKeyframes(findNode(*p, "a"));
 		});
 
+		it("converts or ignores keys of another type than the property", [&]()
+		{
+			p->mutate([&](Document::Builder& mut)
+			{
+				mut.mutate(findNode(*p, "a"), [&](Node::Builder& node)
+				{
+					node.mutateProperty(hash("int"), [&](Property::Builder& prop) { prop.set(0, 2.6); prop.set(10, "text"); });
+					node.mutateProperty(hash("double"), [&](Property::Builder& prop) { prop.set(0, 3); prop.set(10, glm::vec2(1, 2)); });
+				});
+			});
+
+			auto node = findNode(*p, "a");
+			AssertThat(prop(*node, "int")->keys(), Equals(Property::keys_t { 0 }));
+			AssertThat(prop(*node, "int")->get<int>(0), Equals(3));
+			AssertThat(prop(*node, "double")->keys(), Equals(Property::keys_t { 0 }));
+			AssertThat(prop(*node, "double")->get<double>(0), Equals(3.0));
+		});
+
+		it("keeps properties with identical keys apart", [&]()
+		{
+			p->mutate([&](auto& mut) { mut.append({ makeNode(hash("TestNode"), "b") }); });
+			p->mutate([&](Document::Builder& mut)
+			{
+				TestNode::addKeyframes(mut, findNode(*p, "a"));
+				TestNode::addKeyframes(mut, findNode(*p, "b"));
+			});
+			AssertThat(prop(*findNode(*p, "a"), "double") == prop(*findNode(*p, "b"), "double"), Equals(false));
+
+			// Changing one of them must leave the data the other one shares with it alone
+			p->mutate([&](Document::Builder& mut)
+			{
+				mut.mutate(findNode(*p, "b"), [&](Node::Builder& node)
+				{
+					node.mutateProperty(hash("double"), [&](Property::Builder& prop) { prop.set(50, 1000.0); prop.erase(0); });
+				});
+			});
+			TestNode::assertKeyframes(findNode(*p, "a"));
+			AssertThat(prop<double>(*findNode(*p, "b"), "double", 50), Equals(1000.0));
+			AssertThat(prop(*findNode(*p, "b"), "double")->keys().size(), Equals(2));
+		});
+
+		it("keeps the keys of copied builders apart", [&]()
+		{
+			Property::Builder original(*prop(*findNode(*p, "a"), "double"));
+			original.set(0, 1.0);
+
+			Property::Builder copy(original);
+			Property::Builder assigned(*prop(*findNode(*p, "a"), "double"));
+			assigned = original;
+			Property::Builder toBuild(original);
+			Property built(std::move(toBuild));
+
+			// The original goes on changing its keys after being copied
+			original.set(10, 2.0);
+			original.set(0, 3.0);
+			Property changed(std::move(original));
+			AssertThat(changed.keys().size(), Equals(2));
+			AssertThat(changed.get<double>(0), Equals(3.0));
+
+			for (auto&& copied : { Property(std::move(copy)), Property(std::move(assigned)), built })
+			{
+				AssertThat(copied.keys(), Equals(Property::keys_t { 0 }));
+				AssertThat(copied.get<double>(0), Equals(1.0));
+			}
+		});
+
 		it("can add a connector", [&]()
 		{
 			p->mutate([&](Document::Builder& mut)
@@ -144,6 +299,24 @@ go_bandit([]() {
 			p->redo();
 			AssertThat(connector(*findNode(*p, "a"), "Test") == nullptr, Equals(false));
 		});
+
+		it("keeps a connector instance per node", [&]()
+		{
+			p->mutate([&](auto& mut) { mut.append({ makeNode(hash("TestNode"), "b") }); });
+			p->mutate([&](Document::Builder& mut)
+			{
+				for (auto&& title : { "a", "b" })
+				{
+					mut.mutate(findNode(*p, title), [&](Node::Builder& node) { node.addConnector(ConnectorMetadata::Builder("Test", ConnectorType::Output)); });
+				}
+			});
+
+			auto connector_a = connector(*findNode(*p, "a"), "Test");
+			auto connector_b = connector(*findNode(*p, "b"), "Test");
+			AssertThat(connector_a == connector_b, Equals(false));
+			AssertThat(p->current().parent(*connector_a) == findNode(*p, "a"), Equals(true));
+			AssertThat(p->current().parent(*connector_b) == findNode(*p, "b"), Equals(true));
+		});
 	});
 
 	describe("connection:", [&]()
@@ -191,6 +364,58 @@ go_bandit([]() {
 			AssertThat(p->current().connections().size(), Equals(0));
 		});
 
+		it("keeps the connections of copied builders apart", [&]()
+		{
+			p->mutate([&](auto& mut) { mut.append({ makeNode(hash("TestNode"), "c") }); });
+			auto node_a = findNode(*p, "a");
+			auto node_b = findNode(*p, "b");
+			auto node_c = findNode(*p, "c");
+
+			Document::Builder original(p->current());
+			original.connect(std::make_shared<Connection>(make_tuple(node_b, connector(*node_b, "Out"), node_c, connector(*node_c, "In"))));
+
+			Document::Builder copy(original);
+			Document::Builder assigned(p->current());
+			assigned = original;
+
+			// The original goes on changing its connections after being copied
+			original.connect(std::make_shared<Connection>(make_tuple(node_c, connector(*node_c, "Out"), node_a, connector(*node_a, "In"))));
+			Document copied(std::move(copy));
+			AssertThat(copied.connections().size(), Equals(2));
+
+			assigned.connect(std::make_shared<Connection>(make_tuple(node_a, connector(*node_a, "Out"), node_c, connector(*node_c, "In"))));
+			Document changed(std::move(original));
+			AssertThat(changed.connections().size(), Equals(3));
+			AssertThat(copied.connections().size(), Equals(2));
+			AssertThat(changed.connections()[2]->outputNode() == node_c, Equals(true));
+			AssertThat(Document(std::move(assigned)).connections()[2]->outputNode() == node_a, Equals(true));
+			AssertThat(p->current().connections().size(), Equals(1));
+		});
+
+		it("finds the connections of a node", [&]()
+		{
+			auto node_a = findNode(*p, "a");
+			auto node_b = findNode(*p, "b");
+			AssertThat(p->current().outputConnections(*node_a).size(), Equals(1));
+			AssertThat(p->current().inputConnections(*node_a).size(), Equals(0));
+			AssertThat(p->current().inputConnections(*node_b)[0]->outputNode() == node_a, Equals(true));
+
+			p->mutate([&](Document::Builder& mut)
+			{
+				mut.mutate(node_a, [&](Node::Builder& node)
+				{
+					node.mutateProperty(hash("$Title"), [&](Property::Builder& prop) { prop.set(0, "a2"); });
+				});
+			});
+			AssertThat(p->current().inputConnections(*node_b)[0]->outputNode() == findNode(*p, "a2"), Equals(true));
+			AssertThat(p->current().outputConnections(*findNode(*p, "a2"))[0] == p->current().connections()[0], Equals(true));
+
+			p->mutate([&](auto& mut) { mut.erase({ findNode(*p, "a2") }); });
+			AssertThat(p->current().inputConnections(*node_b).size(), Equals(0));
+			p->undo();
+			AssertThat(p->current().inputConnections(*node_b).size(), Equals(1));
+		});
+
 		describe("can disconnect nodes on deletion", [&]()
 		{
 			before_each([&]()
@@ -209,4 +434,518 @@ go_bandit([]() {
 			});
 		});
 	});
+
+	describe("history:", [&]()
+	{
+		std::unique_ptr<Project> p;
+
+		auto nodesOf = [](const Document& d)
+		{
+			return std::vector<NodePtr>(cbegin(d.nodes()), cend(d.nodes()));
+		};
+
+		auto changeTitle = [](Project& p, NodePtr node, std::string title)
+		{
+			p.mutate([&](Document::Builder& mut)
+			{
+				mut.mutate(node, [&](Node::Builder& n)
+				{
+					n.mutateProperty(hash("$Title"), [&](Property::Builder& prop) { prop.set(0, title); });
+				});
+			});
+		};
+
+		before_each([&]()
+		{
+			p = std::make_unique<Project>();
+			p->mutate([](auto& mut) { for (int i = 0; i < 100; i++) mut.append({ makeNode(hash("TestNode"), "node" + std::to_string(i)) }); });
+		});
+
+		it("restores every step when storing deltas", [&]()
+		{
+			p->setHistorySettings({ Project::HistoryMode::Deltas, 3, 0 });
+
+			std::vector<std::vector<NodePtr>> steps { nodesOf(p->current()) };
+			for (int i = 0; i < 10; i++)
+			{
+				if (i % 3 == 0) p->mutate([&](auto& mut) { mut.append({ makeNode(hash("TestNode"), "extra") }); });
+				else if (i % 3 == 1) p->mutate([&](auto& mut) { mut.erase({ findNode(*p, "node" + std::to_string(i)) }); });
+				else changeTitle(*p, findNode(*p, "node" + std::to_string(i)), "changed");
+				steps.push_back(nodesOf(p->current()));
+			}
+
+			for (int i = 9; i >= 0; i--)
+			{
+				p->undo();
+				AssertThat(nodesOf(p->current()), Equals(steps[i]));
+			}
+
+			for (int i = 1; i <= 10; i++)
+			{
+				p->redo();
+				AssertThat(nodesOf(p->current()), Equals(steps[i]));
+			}
+		});
+
+		it("uses less memory when storing deltas", [&]()
+		{
+			Project deltas;
+			deltas.setHistorySettings({ Project::HistoryMode::Deltas, 32, 0 });
+			deltas.mutate([](auto& mut) { for (int i = 0; i < 100; i++) mut.append({ makeNode(hash("TestNode"), "node" + std::to_string(i)) }); });
+
+			for (int i = 0; i < 20; i++)
+			{
+				changeTitle(*p, findNode(*p, "node" + std::to_string(i)), "changed");
+				changeTitle(deltas, findNode(deltas, "node" + std::to_string(i)), "changed");
+			}
+
+			AssertThat(deltas.historyBytes(), IsLessThan(p->historyBytes()));
+		});
+
+		it("drops the oldest steps to stay within the memory budget", [&]()
+		{
+			p->setHistorySettings({ Project::HistoryMode::Deltas, 4, 0 });
+			for (int i = 0; i < 20; i++) changeTitle(*p, findNode(*p, "node" + std::to_string(i)), "changed");
+
+			auto budget = p->historyBytes() / 2;
+			p->setHistorySettings({ Project::HistoryMode::Deltas, 4, budget });
+			AssertThat(p->historyBytes(), !IsGreaterThan(budget));
+
+			size_t undoSteps = 0;
+			while (p->undoState().canUndo)
+			{
+				p->undo();
+				undoSteps++;
+			}
+			AssertThat(undoSteps, IsLessThan(21));
+			AssertThat(p->current().totalChildCount(*p->root()), Equals(100));
+			AssertThat(findNode(*p, "node19") == nullptr, Equals(false));
+		});
+
+		it("keeps taking snapshots while the history is trimmed", [&]()
+		{
+			const size_t interval = 4;
+			p->setHistorySettings({ Project::HistoryMode::Deltas, interval, 0 });
+			changeTitle(*p, findNode(*p, "node0"), "changed");
+			auto before = p->historyBytes();
+			for (int i = 1; i < 5; i++) changeTitle(*p, findNode(*p, "node" + std::to_string(i)), "changed");
+
+			// Room for about twice the last steps, which leaves a history that is not a multiple of the interval
+			p->setHistorySettings({ Project::HistoryMode::Deltas, interval, (p->historyBytes() - before) * 2 });
+
+			for (int i = 5; i < 60; i++)
+			{
+				changeTitle(*p, findNode(*p, "node" + std::to_string(i)), "changed");
+
+				// Restoring any step replays fewer deltas than the interval
+				size_t sinceSnapshot = 0;
+				for (auto&& step : p->history())
+				{
+					sinceSnapshot = step.snapshot ? 0 : sinceSnapshot + 1;
+					AssertThat(sinceSnapshot, IsLessThan(interval));
+				}
+			}
+			AssertThat(p->history().size(), IsLessThan(20));
+		});
+	});
+
+	describe("sampling:", [&]()
+	{
+		std::unique_ptr<Project> p;
+
+		before_each([&]()
+		{
+			p = std::make_unique<Project>();
+			p->mutate([](auto& mut) { mut.append({ makeNode(hash("TestNode"), "a") }); });
+			p->mutate([&](Document::Builder& mut) { TestNode::addKeyframes(mut, findNode(*p, "a")); });
+			p->mutate([&](Document::Builder& mut)
+			{
+				mut.mutate(findNode(*p, "a"), [&](Node::Builder& node)
+				{
+					node.mutateProperty(hash("double"), [&](Property::Builder& prop) { prop.set(40, 100.0); prop.set(60, -100.0); });
+				});
+			});
+		});
+
+		it("samples a range of frames like sampling them one by one", [&]()
+		{
+			auto node = findNode(*p, "a");
+			auto defaultInstructionSet = CubicKernel::instructionSet();
+
+			// The kernels evaluate the spline in a different order than the interpolator, so allow for rounding differences
+			for (auto instructionSet : { CubicKernel::InstructionSet::Scalar, CubicKernel::InstructionSet::SSE2, CubicKernel::InstructionSet::AVX })
+			{
+				if (!CubicKernel::supports(instructionSet)) continue;
+				CubicKernel::setInstructionSet(instructionSet);
+
+				std::vector<double> doubles(250);
+				std::vector<glm::vec2> vec2s(250);
+				std::vector<glm::vec3> vec3s(250);
+				std::vector<std::string> strings(250);
+				prop(*node, "double")->sampleRange(-10, 0.5f, doubles.size(), doubles.data());
+				prop(*node, "vec2")->sampleRange(-10, 0.5f, vec2s.size(), vec2s.data());
+				prop(*node, "vec3")->sampleRange(-10, 0.5f, vec3s.size(), vec3s.data());
+				prop(*node, "string")->sampleRange(-10, 0.5f, strings.size(), strings.data());
+
+				for (size_t i = 0; i < doubles.size(); i++)
+				{
+					Frame frame = -10 + 0.5f * static_cast<Frame>(i);
+					AssertThat(doubles[i], EqualsWithDelta(prop(*node, "double")->get<double>(frame), 1e-3));
+					for (int c = 0; c < 2; c++) AssertThat(vec2s[i][c], EqualsWithDelta(prop(*node, "vec2")->get<glm::vec2>(frame)[c], 1e-3f));
+					for (int c = 0; c < 3; c++) AssertThat(vec3s[i][c], EqualsWithDelta(prop(*node, "vec3")->get<glm::vec3>(frame)[c], 1e-3f));
+					AssertThat(strings[i], Equals(prop(*node, "string")->get<std::string>(frame)));
+				}
+			}
+
+			CubicKernel::setInstructionSet(defaultInstructionSet);
+		});
+
+		it("samples every property of a document", [&]()
+		{
+			auto node = findNode(*p, "a");
+			Sampler sampler(p->current(), 0, 25, 5);
+
+			auto ints = sampler.samples<int>(*prop(*node, "int"));
+			AssertThat(ints == nullptr, Equals(false));
+			AssertThat(sampler.samples<double>(*prop(*node, "int")) == nullptr, Equals(true));
+			AssertThat(ints[0], Equals(-500));
+			AssertThat(ints[2], Equals(0));
+			AssertThat(ints[4], Equals(500));
+
+			auto titles = sampler.samples<std::string>(*prop(*node, "$Title"));
+			AssertThat(titles[3], Equals("a"));
+
+			auto doubles = sampler.samples<double>(*prop(*node, "double"));
+			for (size_t i = 0; i < sampler.count(); i++)
+			{
+				AssertThat(doubles[i], EqualsWithDelta(prop(*node, "double")->get<double>(25.0f * i), 1e-3));
+			}
+		});
+
+		it("returns from a parallel loop only once every range is done", [&]()
+		{
+			ThreadPool pool(3);
+			std::vector<std::atomic<int>> visits(64);
+			for (int round = 0; round < 10; round++)
+			{
+				// Slow ranges, so the caller runs out of tasks to take while others are still running
+				pool.parallelFor(visits.size(), 4, [&](size_t begin, size_t end)
+				{
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+					for (auto i = begin; i < end; i++) visits[i]++;
+				});
+				for (auto&& v : visits) AssertThat(v.load(), Equals(round + 1));
+			}
+		});
+
+		it("evaluates a document on several threads like sampling it serially", [&]()
+		{
+			p->mutate([](auto& mut) { for (int i = 0; i < 50; i++) mut.append({ makeNode(hash("TestNode"), "node" + std::to_string(i)) }); });
+
+			ThreadPool pool(4);
+			SceneEvaluator evaluator(p->current(), 0, 25, 5, pool);
+			Sampler sampler(p->current(), 0, 25, 5);
+
+			AssertThat(evaluator.nodeCount(), Equals(p->current().nodes().size()));
+			for (auto&& node : p->current().nodes())
+			{
+				auto index = evaluator.nodeIndex(*node);
+				AssertThat(index, IsLessThan(evaluator.nodeCount()));
+				AssertThat(evaluator.propertyCount(index), Equals(node->properties().size()));
+
+				for (size_t i = 0; i < node->properties().size(); i++)
+				{
+					auto& property = *node->properties()[i];
+					if (auto ints = evaluator.samples<int>(index, i))
+					{
+						for (size_t f = 0; f < 5; f++) AssertThat(ints[f], Equals(sampler.samples<int>(property)[f]));
+					}
+					if (auto doubles = evaluator.samples<double>(index, i))
+					{
+						for (size_t f = 0; f < 5; f++) AssertThat(doubles[f], Equals(sampler.samples<double>(property)[f]));
+					}
+					if (auto strings = evaluator.samples<std::string>(index, i))
+					{
+						for (size_t f = 0; f < 5; f++) AssertThat(strings[f], Equals(sampler.samples<std::string>(property)[f]));
+					}
+				}
+			}
+
+			auto a = findNode(*p, "a");
+			auto& properties = a->properties();
+			auto title = std::find(begin(properties), end(properties), prop(*a, "$Title")) - begin(properties);
+			AssertThat(evaluator.samples<double>(evaluator.nodeIndex(*a), title) == nullptr, Equals(true));
+			AssertThat(evaluator.samples<std::string>(evaluator.nodeIndex(*a), title)[3], Equals("a"));
+		});
+	});
+
+	describe("visibility:", [&]()
+	{
+		std::unique_ptr<Project> p;
+
+		auto setVisibility = [&](const char* title, visibility_t visibility)
+		{
+			p->mutate([&](Document::Builder& mut)
+			{
+				mut.mutate(findNode(*p, title), [&](Node::Builder& node) { node.mutateVisibility(visibility); });
+			});
+		};
+
+		auto titles = [&](const std::vector<NodePtr>& nodes)
+		{
+			std::vector<std::string> result;
+			for (auto&& node : nodes) result.push_back(prop<std::string>(*node, "$Title", 0));
+			return result;
+		};
+
+		before_each([&]()
+		{
+			p = std::make_unique<Project>();
+			p->mutate([](auto& mut)
+			{
+				mut.append({ makeNode(hash("TestNode"), "a") });
+				mut.append({ makeNode(hash("TestNode"), "b") });
+				mut.append({ makeNode(hash("TestNode"), "c") });
+			});
+			setVisibility("a", { 0, 100 });
+			setVisibility("b", { 50, 150 });
+			setVisibility("c", { 200, 300 });
+		});
+
+		it("finds the nodes active at a frame", [&]()
+		{
+			AssertThat(titles(p->current().activeNodes(25)), Equals(std::vector<std::string> { "a" }));
+			AssertThat(titles(p->current().activeNodes(75)), Equals(std::vector<std::string> { "a", "b" }));
+			AssertThat(titles(p->current().activeNodes(100)), Equals(std::vector<std::string> { "b" }));
+			AssertThat(titles(p->current().activeNodes(175)), Equals(std::vector<std::string> {}));
+			AssertThat(titles(p->current().activeNodes(200)), Equals(std::vector<std::string> { "c" }));
+		});
+
+		it("finds the nodes active in a range of frames", [&]()
+		{
+			AssertThat(titles(p->current().activeNodes(120, 180)), Equals(std::vector<std::string> { "b" }));
+			AssertThat(titles(p->current().activeNodes(90, 250)), Equals(std::vector<std::string> { "a", "b", "c" }));
+			AssertThat(titles(p->current().activeNodes(150, 199)), Equals(std::vector<std::string> {}));
+		});
+
+		it("follows mutations, erasing and undo", [&]()
+		{
+			setVisibility("c", { 10, 20 });
+			AssertThat(titles(p->current().activeNodes(15)), Equals(std::vector<std::string> { "a", "c" }));
+
+			p->mutate([&](Document::Builder& mut)
+			{
+				mut.append(findNode(*p, "c"), { makeNode(hash("TestNode"), "d") });
+			});
+			AssertThat(titles(p->current().activeNodes(500)), Equals(std::vector<std::string> { "d" }));
+
+			p->mutate([&](Document::Builder& mut) { mut.erase({ findNode(*p, "c") }); });
+			AssertThat(titles(p->current().activeNodes(15)), Equals(std::vector<std::string> { "a" }));
+			AssertThat(titles(p->current().activeNodes(500)), Equals(std::vector<std::string> {}));
+
+			p->undo();
+			p->undo();
+			AssertThat(titles(p->current().activeNodes(15)), Equals(std::vector<std::string> { "a", "c" }));
+			p->undo();
+			AssertThat(titles(p->current().activeNodes(250)), Equals(std::vector<std::string> { "c" }));
+		});
+	});
+
+	describe("scheduling:", [&]()
+	{
+		std::unique_ptr<Project> p;
+
+		auto connect = [&](Document::Builder& mut, const char* from, const char* to)
+		{
+			auto output = findNode(*p, from);
+			auto input = findNode(*p, to);
+			mut.connect(std::make_shared<Connection>(make_tuple(output, connector(*output, "Out"), input, connector(*input, "In"))));
+		};
+
+		auto waveOf = [&](const GraphScheduler& scheduler, const char* title)
+		{
+			auto node = findNode(*p, title);
+			for (size_t i = 0; i < scheduler.waves().size(); i++)
+			{
+				auto& wave = scheduler.waves()[i];
+				if (std::find(begin(wave), end(wave), node) != end(wave)) return i;
+			}
+			return scheduler.waves().size();
+		};
+
+		before_each([&]()
+		{
+			p = std::make_unique<Project>();
+			p->mutate([&](auto& mut)
+			{
+				for (auto title : { "a", "b", "c", "d", "e" }) mut.append({ makeNode(hash("TestNode"), title) });
+			});
+
+			// A diamond from a to d; e is not connected at all
+			p->mutate([&](auto& mut)
+			{
+				connect(mut, "a", "b");
+				connect(mut, "a", "c");
+				connect(mut, "b", "d");
+				connect(mut, "c", "d");
+			});
+		});
+
+		it("orders nodes after the nodes connected to their inputs", [&]()
+		{
+			GraphScheduler scheduler(p->current());
+			AssertThat(scheduler.hasCycle(), Equals(false));
+			AssertThat(scheduler.waves().size(), Equals(3));
+			AssertThat(waveOf(scheduler, "a"), Equals(0));
+			AssertThat(waveOf(scheduler, "e"), Equals(0));
+			AssertThat(waveOf(scheduler, "b"), Equals(1));
+			AssertThat(waveOf(scheduler, "c"), Equals(1));
+			AssertThat(waveOf(scheduler, "d"), Equals(2));
+		});
+
+		it("runs every node after its inputs and times it", [&]()
+		{
+			GraphScheduler scheduler(p->current());
+			ThreadPool pool(4);
+
+			std::mutex mutex;
+			std::vector<NodePtr> order;
+			scheduler.run(pool, [&](const NodePtr& node)
+			{
+				if (node == findNode(*p, "d")) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				std::lock_guard<std::mutex> lock(mutex);
+				order.push_back(node);
+			});
+
+			auto position = [&](const char* title) { return std::find(begin(order), end(order), findNode(*p, title)) - begin(order); };
+			AssertThat(order.size(), Equals(p->current().nodes().size()));
+			AssertThat(position("a"), IsLessThan(position("b")));
+			AssertThat(position("a"), IsLessThan(position("c")));
+			AssertThat(position("b"), IsLessThan(position("d")));
+			AssertThat(position("c"), IsLessThan(position("d")));
+			AssertThat(scheduler.duration(*findNode(*p, "d")) >= std::chrono::milliseconds(1), Equals(true));
+		});
+
+		it("leaves out nodes on or behind a cycle", [&]()
+		{
+			p->mutate([&](auto& mut) { connect(mut, "d", "b"); });
+
+			GraphScheduler scheduler(p->current());
+			AssertThat(scheduler.hasCycle(), Equals(true));
+			AssertThat(scheduler.cyclicNodes().size(), Equals(2));
+			AssertThat(waveOf(scheduler, "a"), Equals(0));
+			AssertThat(waveOf(scheduler, "c"), Equals(1));
+			AssertThat(waveOf(scheduler, "b"), Equals(scheduler.waves().size()));
+			AssertThat(waveOf(scheduler, "d"), Equals(scheduler.waves().size()));
+
+			std::atomic<size_t> ran { 0 };
+			ThreadPool pool(2);
+			scheduler.run(pool, [&](const NodePtr&) { ran++; });
+			AssertThat(ran.load(), Equals(p->current().nodes().size() - 2));
+		});
+	});
+
+	describe("evaluation cache:", [&]()
+	{
+		std::unique_ptr<Project> p;
+		EvaluationCache<int> cache;
+
+		// The int property of a node plus the results of the nodes connected to its inputs
+		std::function<int(const NodePtr&, Frame)> evaluate = [&](const NodePtr& node, Frame frame)
+		{
+			auto result = prop<int>(*node, "int", frame);
+			for (auto&& connection : p->current().inputConnections(*node)) result += cache.get(connection->outputNode(), frame, evaluate);
+			return result;
+		};
+
+		auto evaluateAll = [&]()
+		{
+			cache.resetCounters();
+			ThreadPool pool(2);
+			GraphScheduler(p->current()).run(pool, [&](const NodePtr& node) { cache.get(node, 0, evaluate); });
+		};
+
+		auto setInt = [&](const char* title, int value)
+		{
+			p->mutate([&](Document::Builder& mut)
+			{
+				mut.mutate(findNode(*p, title), [&](Node::Builder& node)
+				{
+					node.mutateProperty(hash("int"), [&](Property::Builder& prop) { prop.set(0, value); });
+				});
+			});
+		};
+
+		before_each([&]()
+		{
+			cache.clear();
+			p = std::make_unique<Project>();
+			p->mutate([&](auto& mut)
+			{
+				for (auto title : { "a", "b", "c", "d" }) mut.append({ makeNode(hash("TestNode"), title) });
+			});
+
+			// A chain from a to c; d is not connected
+			p->mutate([&](auto& mut)
+			{
+				auto a = findNode(*p, "a"), b = findNode(*p, "b"), c = findNode(*p, "c");
+				mut.connect(std::make_shared<Connection>(make_tuple(a, connector(*a, "Out"), b, connector(*b, "In"))));
+				mut.connect(std::make_shared<Connection>(make_tuple(b, connector(*b, "Out"), c, connector(*c, "In"))));
+			});
+
+			p->setMutationCallback([&](auto mutationInfo) { cache.invalidate(*mutationInfo); });
+			setInt("a", 1);
+			setInt("b", 10);
+			evaluateAll();
+		});
+
+		it("reuses results until something upstream changes", [&]()
+		{
+			AssertThat(cache.misses(), Equals(p->current().nodes().size()));
+			AssertThat(cache.get(findNode(*p, "c"), 0, evaluate), Equals(11));
+
+			evaluateAll();
+			AssertThat(cache.misses(), Equals(0));
+			AssertThat(cache.hits(), IsGreaterThan(p->current().nodes().size() - 1));
+		});
+
+		it("only recomputes the nodes downstream of a change", [&]()
+		{
+			setInt("b", 100);
+			AssertThat(cache.contains(*findNode(*p, "a"), 0), Equals(true));
+			AssertThat(cache.contains(*findNode(*p, "c"), 0), Equals(false));
+
+			evaluateAll();
+			AssertThat(cache.misses(), Equals(2));
+			AssertThat(cache.get(findNode(*p, "c"), 0, evaluate), Equals(101));
+
+			setInt("d", 5);
+			evaluateAll();
+			AssertThat(cache.misses(), Equals(1));
+		});
+
+		it("recomputes the nodes whose inputs were connected or disconnected", [&]()
+		{
+			p->mutate([&](auto& mut)
+			{
+				auto d = findNode(*p, "d"), c = findNode(*p, "c");
+				mut.connect(std::make_shared<Connection>(make_tuple(d, connector(*d, "Out"), c, connector(*c, "In"))));
+			});
+
+			evaluateAll();
+			AssertThat(cache.misses(), Equals(1));
+
+			p->undo();
+			evaluateAll();
+			AssertThat(cache.misses(), Equals(1));
+			AssertThat(cache.get(findNode(*p, "c"), 0, evaluate), Equals(11));
+		});
+
+		it("drops the results of removed nodes", [&]()
+		{
+			auto size = cache.size();
+			p->mutate([&](auto& mut) { mut.erase({ findNode(*p, "d") }); });
+			AssertThat(cache.size(), Equals(size - 1));
+		});
+	});
 });
@@ -0,0 +1,67 @@
+#include "static.h"
+
+using namespace bandit;
+#include "test-utils.h"
+#include "testnode.h"
+#include "benchmark.h"
+
+#include <editor-lib/modules/timeline/model.h>
+
+go_bandit([]() {
+	describe("timeline model benchmark:", []()
+	{
+		it("applies a single node mutation independent of the number of rows", [&]()
+		{
+			const size_t iterations = 200;
+			std::vector<double> timings;
+
+			for (size_t nodeCount : { 1000, 10000 })
+			{
+				Project p;
+				Editor::Modules::Timeline::Model model;
+				p.setMutationCallback([&](auto mutation) { model.apply(mutation); });
+
+				// Grouped into folders of 100 nodes each, like a scene would be
+				std::vector<NodePtr> nodes;
+				p.mutate([&](Document::Builder& b)
+				{
+					NodePtr group;
+					for (size_t i = 0; i < nodeCount; i++)
+					{
+						if (i % 100 == 0)
+						{
+							group = makeNode(hash("TestNode"), "group");
+							b.append({ group });
+						}
+
+						auto node = makeNode(hash("TestNode"), "node");
+						b.append(group, { node });
+						nodes.push_back(node);
+					}
+				});
+				AssertThat(model.rowCount(), Equals(nodeCount / 100));
+
+				auto time = measure(iterations, [&](size_t i)
+				{
+					auto node = p.current().find(nodes[(i * 7919) % nodes.size()]->uuid());
+					p.mutate([&](Document::Builder& mut)
+					{
+						mut.mutate(node, [&](Node::Builder& n)
+						{
+							n.mutateProperty(hash("double"), [&](Property::Builder& prop) { prop.set(0, static_cast<double>(i + 1)); });
+						});
+					});
+				});
+
+				auto last = p.current().find(nodes[((iterations - 1) * 7919) % nodes.size()]->uuid());
+				AssertThat(model.nodeFromIndex(model.findItemIndex(last)) == last, Equals(true));
+				AssertThat(model.findItemIndex(last->uuid()) == model.findItemIndex(last), Equals(true));
+
+				LOG->info("Applying a single node mutation to a model of {} nodes: {:.3f} us", nodeCount, time);
+				timings.push_back(time);
+			}
+
+			AssertThat(timings.back(), IsLessThan(timings.front() * 3));
+		});
+	});
+});
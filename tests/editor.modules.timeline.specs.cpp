@@ -6,7 +6,24 @@ using namespace bandit;
 #include "testnode.h"
 #include "modeltest.h"
 
+#include <editor-lib/event_bus.h>
 #include <editor-lib/modules/timeline/model.h>
+#include <editor-lib/modules/timeline/widget.h>
+#include <editor-lib/modules/timeline/keyframer/delegate.h>
+#include <editor-lib/modules/timeline/keyframer/interaction_state.h>
+#include <editor-lib/modules/timeline/keyframer/tree_view.h>
+#include <editor-lib/modules/timeline/keyframer/widget.h>
+#include <editor-lib/modules/timeline/keyframer/editors/node_editor.h>
+#include <editor-lib/modules/timeline/keyframer/editors/property/key_diff.h>
+
+#include <QtTest/QtTest>
+
+using Editor::EventBus;
+using Editor::Modules::Timeline::Keyframer::Delegate;
+using Editor::Modules::Timeline::Keyframer::InteractionState;
+using Editor::Modules::Timeline::Keyframer::TreeView;
+using Editor::Modules::Timeline::Keyframer::TrimEdge;
+using KeyframerWidget = Editor::Modules::Timeline::Keyframer::Widget;
 
 go_bandit([]() {
 	describe("editor.modules.timeline:", []()
@@ -174,5 +191,547 @@ go_bandit([]() {
 
 			AssertThat(newSelection.size(), Equals(0));
 		});
+
+		it("inserts and removes many rows with few notifications", [&]()
+		{
+			size_t inserted = 0, removed = 0, layoutChanged = 0, dataChanged = 0;
+			QObject::connect(model.get(), &QAbstractItemModel::rowsInserted, [&]() { inserted++; });
+			QObject::connect(model.get(), &QAbstractItemModel::rowsRemoved, [&]() { removed++; });
+			QObject::connect(model.get(), &QAbstractItemModel::layoutChanged, [&]() { layoutChanged++; });
+			QObject::connect(model.get(), &QAbstractItemModel::dataChanged, [&]() { dataChanged++; });
+
+			// A new group arrives in the model as a single row, with all of its children in place
+			p->mutate([&](Document::Builder& mut)
+			{
+				auto group = makeNode(hash("TestNode"), "group");
+				mut.append({ group });
+				for (int i = 0; i < 100; i++) mut.append(group, { makeNode(hash("TestNode"), "node" + std::to_string(i)) });
+			});
+			assertModel();
+			AssertThat(inserted, Equals(1));
+
+			p->undo();
+			AssertThat(model->rowCount(), Equals(0));
+			AssertThat(removed, Equals(1));
+
+			// Neighbouring rows are inserted and removed in one go
+			inserted = 0;
+			p->mutate([&](Document::Builder& mut) { for (int i = 0; i < 100; i++) mut.append({ makeNode(hash("TestNode"), "node" + std::to_string(i)) }); });
+			assertModel();
+			AssertThat(inserted, Equals(1));
+
+			removed = 0;
+			p->mutate([&](Document::Builder& mut)
+			{
+				std::vector<NodePtr> nodes;
+				for (size_t i = 0; i < p->current().childCount(*p->current().root()); i++) nodes.push_back(p->current().child(*p->current().root(), i));
+				mut.erase(nodes);
+			});
+			AssertThat(model->rowCount(), Equals(0));
+			AssertThat(removed, Equals(1));
+
+			// Rows arrive with their cells filled in, so the views never have to lay out the model again
+			AssertThat(layoutChanged, Equals(0));
+			AssertThat(dataChanged, Equals(0));
+		});
+
+		it("inserts rows in document order while siblings are removed", [&]()
+		{
+			p->mutate([&](Document::Builder& mut)
+			{
+				for (auto&& title : { "x", "a", "b" }) mut.append({ makeNode(hash("TestNode"), title) });
+			});
+
+			// The row of x is still in the model when c is inserted
+			p->mutate([&](Document::Builder& mut)
+			{
+				mut.erase({ findNode(*p, "x") });
+				mut.insertBefore(findNode(*p, "b"), { makeNode(hash("TestNode"), "c") });
+			});
+
+			assertModel();
+			AssertThat(model->rowCount(), Equals(3));
+			AssertThat(model->data(model->index(0, 0), Qt::DisplayRole).toString().toStdString(), Equals("a"));
+			AssertThat(model->data(model->index(1, 0), Qt::DisplayRole).toString().toStdString(), Equals("c"));
+			AssertThat(model->data(model->index(2, 0), Qt::DisplayRole).toString().toStdString(), Equals("b"));
+		});
+
+		it("reuses key widgets when keys are dragged", [&]()
+		{
+			using Editor::Modules::Timeline::Keyframer::Editors::Property::diffKeys;
+
+			p->mutate({
+				[&](Document::Builder& mut) { mut.append({ makeNode(hash("TestNode"), "keys") }); },
+				[&](Document::Builder& mut)
+				{
+					mut.mutate(findNode(*p, "keys"), [&](Node::Builder& node)
+					{
+						node.mutateProperty(hash("int"), [&](Property::Builder& prop) { for (int i = 0; i < 500; i++) prop.set(static_cast<Frame>(i * 10), i); });
+					});
+				}
+			}, "create keys");
+
+			auto intProperty = [&]()
+			{
+				for (auto&& prop : findNode(*p, "keys")->properties()) if (prop->metadata().hash() == hash("int")) return prop;
+				return PropertyPtr();
+			};
+			auto keys = [&]() { return intProperty()->keys(); };
+
+			// Drags the widgets by offset, then applies the drag to the document like the property editor does
+			auto drag = [&](std::vector<Frame>& widgets, std::vector<size_t> dragged, Frame offset)
+			{
+				auto prop = intProperty();
+				p->mutate([&](Document::Builder& mut)
+				{
+					mut.mutate(findNode(*p, "keys"), [&](Node::Builder& node)
+					{
+						node.mutateProperty(prop, [&](Property::Builder& pb)
+						{
+							for (auto&& i : dragged) pb.erase(widgets[i]);
+							for (auto&& i : dragged) pb.set(widgets[i] + offset, prop->getPropertyValue(widgets[i]));
+						});
+					});
+				}, "drag");
+				for (auto&& i : dragged) widgets[i] += offset;
+			};
+
+			std::vector<Frame> widgets = keys();
+			AssertThat(widgets.size(), Equals(500));
+
+			// One key
+			drag(widgets, { 250 }, 5);
+			auto diff = diffKeys(widgets, keys());
+			AssertThat(diff.kept.size(), Equals(500));
+			AssertThat(diff.added.size(), Equals(0));
+			AssertThat(diff.removed.size(), Equals(0));
+
+			// All keys, onto each other's frames
+			std::vector<size_t> all;
+			for (size_t i = 0; i < widgets.size(); i++) all.push_back(i);
+			drag(widgets, all, 10);
+			diff = diffKeys(widgets, keys());
+			AssertThat(diff.kept.size(), Equals(500));
+			AssertThat(diff.added.size(), Equals(0));
+			AssertThat(diff.removed.size(), Equals(0));
+
+			// Undoing a drag moves the widget back instead of replacing it
+			drag(widgets, { 0 }, 2);
+			p->undo();
+			diff = diffKeys(widgets, keys());
+			AssertThat(diff.kept.size(), Equals(499));
+			AssertThat(diff.moved.size(), Equals(1));
+			AssertThat(diff.added.size(), Equals(0));
+
+			// Only added and removed keys need a widget to be created or destroyed
+			widgets = keys();
+			p->mutate([&](Document::Builder& mut)
+			{
+				mut.mutate(findNode(*p, "keys"), [&](Node::Builder& node)
+				{
+					node.mutateProperty(hash("int"), [&](Property::Builder& prop) { prop.set(-10, 0); prop.set(-20, 0); prop.erase(100); });
+				});
+			}, "add and remove keys");
+			diff = diffKeys(widgets, keys());
+			AssertThat(diff.kept.size(), Equals(499));
+			AssertThat(diff.moved.size(), Equals(1));
+			AssertThat(diff.added.size(), Equals(1));
+			AssertThat(diff.removed.size(), Equals(0));
+		});
+	});
+
+	describe("editor.modules.timeline.keyframer interaction state:", []()
+	{
+		using DragType = InteractionState::DragType;
+
+		InteractionState state;
+		Uuid a, b;
+
+		before_each([&]()
+		{
+			state = InteractionState();
+			a = uuid4();
+			b = uuid4();
+		});
+
+		it("selects and deselects nodes and keys", [&]()
+		{
+			InteractionState::Key key { a, hash("int"), 100 };
+
+			state.setSelected(a, true);
+			state.setSelected(key, true);
+			AssertThat(state.isSelected(a), IsTrue());
+			AssertThat(state.isSelected(b), IsFalse());
+			AssertThat(state.isSelected(key), IsTrue());
+			AssertThat(state.isSelected(InteractionState::Key { a, hash("int"), 0 }), IsFalse());
+			AssertThat(state.isSelected(InteractionState::Key { a, hash("double"), 100 }), IsFalse());
+
+			state.setSelected(a, false);
+			AssertThat(state.isSelected(a), IsFalse());
+			AssertThat(state.isSelected(key), IsTrue());
+
+			state.setSelected(b, true);
+			state.clear();
+			AssertThat(state.selectedNodes().empty(), IsTrue());
+			AssertThat(state.selectedKeys().empty(), IsTrue());
+		});
+
+		it("accumulates a drag until it ends", [&]()
+		{
+			InteractionState::Key key { b, hash("int"), 0 };
+
+			state.startDrag(DragType::Trim, TrimEdge::Stop, { a }, { key });
+			state.dragBy(10);
+			state.dragBy(-4);
+			AssertThat(state.dragType() == DragType::Trim, IsTrue());
+			AssertThat(state.trimEdge() == TrimEdge::Stop, IsTrue());
+			AssertThat(state.dragOffset(), Equals(6));
+			AssertThat(state.isDragged(a), IsTrue());
+			AssertThat(state.isDragged(b), IsFalse());
+			AssertThat(state.isDragged(key), IsTrue());
+
+			// A new drag starts from scratch
+			state.startDrag(DragType::Move, TrimEdge::Start, { b }, {});
+			AssertThat(state.dragOffset(), Equals(0));
+			AssertThat(state.isDragged(a), IsFalse());
+			AssertThat(state.isDragged(key), IsFalse());
+
+			state.dragBy(3);
+			state.endDrag();
+			AssertThat(state.dragType() == DragType::None, IsTrue());
+			AssertThat(state.dragOffset(), Equals(0));
+			AssertThat(state.draggedNodes().empty(), IsTrue());
+			AssertThat(state.draggedKeys().empty(), IsTrue());
+		});
+
+		it("moves only the selected keys along with a drag", [&]()
+		{
+			InteractionState::Key moved { a, hash("int"), 0 };
+			InteractionState::Key kept { a, hash("int"), 100 };
+			InteractionState::Key unselected { b, hash("int"), 0 };
+
+			state.setSelected(moved, true);
+			state.setSelected(kept, true);
+			state.moveSelectedKeys({ moved, unselected }, 20);
+
+			AssertThat(state.selectedKeys().size(), Equals(2));
+			AssertThat(state.isSelected(moved), IsFalse());
+			AssertThat(state.isSelected(InteractionState::Key { a, hash("int"), 20 }), IsTrue());
+			AssertThat(state.isSelected(kept), IsTrue());
+			AssertThat(state.isSelected(InteractionState::Key { b, hash("int"), 20 }), IsFalse());
+
+			// A key can be moved onto the frame of another selected key that moves away
+			state.moveSelectedKeys({ InteractionState::Key { a, hash("int"), 20 }, kept }, 80);
+			AssertThat(state.isSelected(kept), IsTrue());
+			AssertThat(state.isSelected(InteractionState::Key { a, hash("int"), 180 }), IsTrue());
+			AssertThat(state.selectedKeys().size(), Equals(2));
+		});
+	});
+
+	describe("editor.modules.timeline.keyframer virtualized tree view:", []()
+	{
+		std::unique_ptr<Project> p;
+		std::unique_ptr<Editor::Modules::Timeline::Widget> timeline;
+		std::unique_ptr<QObject> listener;
+		std::unordered_set<Uuid> selectedNodes;
+		TreeView* view;
+		Uuid node;
+
+		before_each([&]()
+		{
+			p = std::make_unique<Project>();
+			timeline = std::make_unique<Editor::Modules::Timeline::Widget>(nullptr, *p);
+			timeline->setVirtualizedKeyframer(true);
+			p->setMutationCallback([&](std::shared_ptr<Core::MutationInfo> mutationInfo) { timeline->projectMutated(mutationInfo); });
+
+			timeline->resize(1200, 600);
+			timeline->show();
+			QTest::qWaitForWindowExposed(timeline.get());
+			view = timeline->findChild<TreeView*>();
+
+			selectedNodes.clear();
+			listener = std::make_unique<QObject>();
+			QObject::connect(&EventBus::instance(), &EventBus::nodeSelectionChanged, listener.get(), [&](NodePtr n, bool selected)
+			{
+				if (selected) selectedNodes.insert(n->uuid());
+				else selectedNodes.erase(n->uuid());
+			});
+
+			// A node spanning frames 50 to 150, with keys at frames 0 and 100
+			auto n = makeNode(hash("TestNode"), "node");
+			node = n->uuid();
+			p->mutate([&](Document::Builder& mut) { mut.append({ n }); });
+			p->mutate([&](Document::Builder& mut)
+			{
+				mut.mutate(n, [&](Node::Builder& builder) { builder.mutateVisibility({ 50, 150 }); });
+				TestNode::addKeyframes(mut, n);
+			});
+		});
+
+		after_each([&]()
+		{
+			listener.reset();
+			timeline.reset();
+			p.reset();
+		});
+
+		auto proxy = [&]() -> QSortFilterProxyModel& { return static_cast<QSortFilterProxyModel&>(*view->model()); };
+		auto current = [&]() { return p->current().find(node); };
+		auto nodeRow = [&]() { return proxy().mapFromSource(timeline->model().findItemIndex(node)); };
+
+		auto propertyRow = [&](const std::string& title)
+		{
+			view->expand(nodeRow());
+			for (int row = 0; row < proxy().rowCount(nodeRow()); row++)
+			{
+				auto index = proxy().index(row, 0, nodeRow());
+				auto prop = timeline->model().propertyFromIndex(proxy().mapToSource(index));
+				if (prop && prop->metadata().title() == title) return index;
+			}
+			return QModelIndex();
+		};
+
+		// Where frame is drawn in row, in viewport coordinates
+		auto at = [&](const QModelIndex& row, Frame frame)
+		{
+			auto origin = view->header()->sectionViewportPosition(static_cast<int>(Editor::Modules::Timeline::Model::Columns::Item));
+			return QPoint(origin + static_cast<int>(frame), view->visualRect(row).center().y());
+		};
+
+		auto click = [&](const QPoint& pos, Qt::KeyboardModifiers modifiers = Qt::NoModifier)
+		{
+			QTest::mouseClick(view->viewport(), Qt::LeftButton, modifiers, pos);
+		};
+
+		// QTest only moves the cursor, so the move with the button held down is sent by hand
+		auto drag = [&](const QPoint& from, const QPoint& to)
+		{
+			QTest::mousePress(view->viewport(), Qt::LeftButton, Qt::NoModifier, from);
+			QMouseEvent move(QEvent::MouseMove, to, view->viewport()->mapToGlobal(to), Qt::NoButton, Qt::LeftButton, Qt::NoModifier);
+			QApplication::sendEvent(view->viewport(), &move);
+			QTest::mouseRelease(view->viewport(), Qt::LeftButton, Qt::NoModifier, to);
+		};
+
+		it("selects a node that is clicked anywhere in its span", [&]()
+		{
+			AssertThat(view->isVirtualized(), IsTrue());
+
+			// Well outside the item column, which is only as wide as the titles
+			click(at(nodeRow(), 140));
+			AssertThat(selectedNodes.count(node), Equals(1));
+
+			click(at(nodeRow(), 140), Qt::ControlModifier);
+			AssertThat(selectedNodes.count(node), Equals(0));
+
+			// Outside of its span, a click starts a rubber band that deselects everything
+			click(at(nodeRow(), 100));
+			click(at(nodeRow(), 200));
+			AssertThat(selectedNodes.count(node), Equals(0));
+		});
+
+		it("deselects its nodes when it stops being virtualized", [&]()
+		{
+			click(at(nodeRow(), 100));
+			AssertThat(selectedNodes.count(node), Equals(1));
+
+			timeline->setVirtualizedKeyframer(false);
+			AssertThat(selectedNodes.count(node), Equals(0));
+		});
+
+		it("moves a node and its keys when it is dragged by its body", [&]()
+		{
+			drag(at(nodeRow(), 100), at(nodeRow(), 120));
+
+			AssertThat(current()->visibility().first, Equals(70));
+			AssertThat(current()->visibility().second, Equals(170));
+			AssertThat(prop(*current(), "int")->get<int>(20), Equals(-500));
+			AssertThat(prop(*current(), "int")->get<int>(120), Equals(500));
+		});
+
+		it("trims a node that is dragged by either edge", [&]()
+		{
+			drag(at(nodeRow(), 151), at(nodeRow(), 171));
+			AssertThat(current()->visibility().first, Equals(50));
+			AssertThat(current()->visibility().second, Equals(170));
+
+			drag(at(nodeRow(), 48), at(nodeRow(), 28));
+			AssertThat(current()->visibility().first, Equals(30));
+			AssertThat(current()->visibility().second, Equals(170));
+
+			// Trimming leaves the keys where they are
+			AssertThat(prop(*current(), "int")->get<int>(100), Equals(500));
+		});
+
+		it("hit tests keys within their radius", [&]()
+		{
+			// Just out of reach, so nothing is selected
+			click(at(propertyRow("int"), 108));
+			timeline->deleteSelected();
+			AssertThat(prop(*current(), "int")->keys().size(), Equals(2));
+
+			click(at(propertyRow("int"), 104));
+			timeline->deleteSelected();
+			AssertThat(prop(*current(), "int")->keys().size(), Equals(1));
+			AssertThat(prop(*current(), "int")->get<int>(100), Equals(-500));
+			AssertThat(prop(*current(), "double")->keys().size(), Equals(2));
+		});
+
+		it("moves a selected key that is dragged, and keeps it selected", [&]()
+		{
+			click(at(propertyRow("int"), 100));
+			drag(at(propertyRow("int"), 100), at(propertyRow("int"), 130));
+			AssertThat(prop(*current(), "int")->get<int>(130), Equals(500));
+			AssertThat(current()->visibility().first, Equals(50));
+
+			timeline->deleteSelected();
+			AssertThat(prop(*current(), "int")->keys().size(), Equals(1));
+		});
+
+		it("selects the nodes and keys a rubber band is dragged over", [&]()
+		{
+			drag(at(propertyRow("int"), 250), at(propertyRow("int"), 90));
+			AssertThat(selectedNodes.count(node), Equals(0));
+
+			timeline->deleteSelected();
+			AssertThat(prop(*current(), "int")->keys().size(), Equals(1));
+			AssertThat(prop(*current(), "double")->keys().size(), Equals(2));
+
+			drag(at(nodeRow(), 250), at(nodeRow(), 140));
+			AssertThat(selectedNodes.count(node), Equals(1));
+
+			timeline->deleteSelected();
+			AssertThat(current() == nullptr, IsTrue());
+		});
+	});
+
+	describe("editor.modules.timeline.keyframer delegate:", []()
+	{
+		std::unique_ptr<Project> p;
+		std::unique_ptr<Editor::Modules::Timeline::Widget> timeline;
+		TreeView* view;
+		Delegate* delegate;
+		std::vector<Uuid> nodes;
+
+		before_each([&]()
+		{
+			p = std::make_unique<Project>();
+			timeline = std::make_unique<Editor::Modules::Timeline::Widget>(nullptr, *p);
+			p->setMutationCallback([&](std::shared_ptr<Core::MutationInfo> mutationInfo) { timeline->projectMutated(mutationInfo); });
+
+			timeline->resize(1200, 600);
+			timeline->show();
+			QTest::qWaitForWindowExposed(timeline.get());
+			view = timeline->findChild<TreeView*>();
+			delegate = qobject_cast<Delegate*>(view->itemDelegateForColumn(static_cast<int>(Editor::Modules::Timeline::Model::Columns::Item)));
+
+			// More nodes than fit in the view, all spanning frames 50 to 150
+			nodes.clear();
+			p->mutate([&](Document::Builder& mut)
+			{
+				for (int i = 0; i < 100; i++)
+				{
+					auto n = makeNode(hash("TestNode"), "node" + std::to_string(i));
+					mut.append({ n });
+					nodes.push_back(n->uuid());
+				}
+			});
+			p->mutate([&](Document::Builder& mut)
+			{
+				for (auto&& uuid : nodes) mut.mutate(p->current().find(uuid), [&](Node::Builder& builder) { builder.mutateVisibility({ 50, 150 }); });
+			});
+		});
+
+		after_each([&]()
+		{
+			timeline.reset();
+			p.reset();
+		});
+
+		auto widget = [&](const Uuid& node) -> KeyframerWidget* { return delegate->editorFor(p->current().find(node))->widget(); };
+		auto globalRect = [&](const QWidget* w) { return QRect(w->mapToGlobal(QPoint()), w->size()); };
+
+		it("keeps track of the widgets that are selected", [&]()
+		{
+			AssertThat(view->isVirtualized(), IsFalse());
+			auto a = widget(nodes[0]);
+			auto b = widget(nodes[1]);
+
+			a->setSelected(true);
+			b->setSelected(true);
+			AssertThat(delegate->isSelected(a), IsTrue());
+			AssertThat(delegate->isSelected(b), IsTrue());
+
+			b->setSelected(false);
+			AssertThat(delegate->isSelected(b), IsFalse());
+
+			delegate->setSelected(b, true);
+			AssertThat(b->isSelected(), IsTrue());
+
+			delegate->resetSelection();
+			AssertThat(a->isSelected(), IsFalse());
+			AssertThat(b->isSelected(), IsFalse());
+			AssertThat(delegate->isSelected(a), IsFalse());
+		});
+
+		it("forgets the widgets that are destroyed", [&]()
+		{
+			auto kept = widget(nodes[1]);
+			widget(nodes[0])->setSelected(true);
+			kept->setSelected(true);
+
+			p->mutate([&](Document::Builder& mut) { mut.erase({ p->current().find(nodes[0]) }); });
+			QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+
+			// Neither deselecting nor a rubber band touches the destroyed widget
+			delegate->resetSelection();
+			AssertThat(kept->isSelected(), IsFalse());
+
+			delegate->setRubberBandSelection(globalRect(view->viewport()));
+			AssertThat(kept->isSelected(), IsTrue());
+			delegate->endRubberBandSelection();
+		});
+
+		it("selects the widgets a rubber band is dragged over", [&]()
+		{
+			auto a = widget(nodes[0]);
+			auto b = widget(nodes[1]);
+			auto c = widget(nodes[2]);
+			c->setSelected(true);
+
+			delegate->setRubberBandSelection(globalRect(a).united(globalRect(b)));
+			AssertThat(a->isSelected(), IsTrue());
+			AssertThat(b->isSelected(), IsTrue());
+			AssertThat(c->isSelected(), IsTrue());
+
+			// Widgets the band leaves again are deselected, unless they were selected before the drag
+			delegate->setRubberBandSelection(globalRect(a));
+			AssertThat(a->isSelected(), IsTrue());
+			AssertThat(b->isSelected(), IsFalse());
+			AssertThat(c->isSelected(), IsTrue());
+
+			delegate->endRubberBandSelection();
+			AssertThat(a->isSelected(), IsTrue());
+		});
+
+		it("finds the widgets again when the view scrolls during a rubber band drag", [&]()
+		{
+			auto band = globalRect(widget(nodes[0]));
+			delegate->setRubberBandSelection(band);
+			AssertThat(widget(nodes[0])->isSelected(), IsTrue());
+
+			view->verticalScrollBar()->setValue(view->verticalScrollBar()->maximum() / 2);
+			QApplication::processEvents();
+
+			// Another node is under the band now
+			auto index = view->indexAt(QPoint(0, view->viewport()->mapFromGlobal(band.center()).y()));
+			auto& proxy = static_cast<QSortFilterProxyModel&>(*view->model());
+			auto node = timeline->model().nodeFromIndex(proxy.mapToSource(index));
+			AssertThat(node->uuid() == nodes[0], IsFalse());
+
+			delegate->setRubberBandSelection(band);
+			AssertThat(widget(node->uuid())->isSelected(), IsTrue());
+			AssertThat(widget(nodes[0])->isSelected(), IsFalse());
+			delegate->endRubberBandSelection();
+		});
 	});
 });
\ No newline at end of file
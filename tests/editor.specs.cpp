@@ -0,0 +1,174 @@
+#include "static.h"
+
+using namespace bandit;
+#include "test-utils.h"
+#include "testnode.h"
+#include "memory_tracker.h"
+
+#include <core/memory_stream.h>
+#include <editor-lib/device_stream.h>
+
+using Editor::DeviceStreamBuf;
+
+// Saves like Application::save, and checks that every byte made it to the device
+template <typename OutputArchive>
+static void saveTo(QIODevice* device, const Project& p)
+{
+	DeviceStreamBuf buffer(device);
+	std::ostream out(&buffer);
+	{
+		OutputArchive archive(out);
+		archive(p);
+	}
+	AssertThat(out.good(), Equals(true));
+	AssertThat(buffer.pubsync(), Equals(0));
+}
+
+template <typename InputArchive>
+static void loadFrom(QIODevice* device, Project& p)
+{
+	DeviceStreamBuf buffer(device);
+	std::istream in(&buffer);
+	InputArchive archive(in);
+	archive(p);
+}
+
+template <typename OutputArchive>
+static std::string saveToString(const Project& p)
+{
+	std::stringstream out(std::ios::out | std::ios::binary);
+	{
+		OutputArchive archive(out);
+		archive(p);
+	}
+	return out.str();
+}
+
+go_bandit([]() {
+	describe("device stream:", []()
+	{
+		// Large enough to take many chunks of the stream buffer
+		const size_t nodeCount = 5000;
+
+		std::unique_ptr<Project> p;
+		std::vector<NodePtr> nodes;
+
+		before_each([&]()
+		{
+			p = std::make_unique<Project>();
+			nodes.clear();
+			p->mutate([&](Document::Builder& b) { addScene(b, nodeCount, nodes); });
+			p->mutate([&](Document::Builder& b) { TestNode::addKeyframes(b, nodes[nodeCount / 2]); });
+		});
+
+		auto assertLoaded = [&](const Project& loaded)
+		{
+			AssertThat(loaded.current().nodes().size(), Equals(p->current().nodes().size()));
+
+			auto node = loaded.current().find(nodes[nodeCount / 2]->uuid());
+			AssertThat(node == nullptr, Equals(false));
+			TestNode::assertKeyframes(node);
+		};
+
+		it("round trips a project through a buffer", [&]()
+		{
+			for (auto json : { false, true })
+			{
+				QBuffer device;
+				device.open(QIODevice::WriteOnly);
+				if (json) saveTo<cereal::JSONOutputArchive>(&device, *p);
+				else saveTo<cereal::PortableBinaryOutputArchive>(&device, *p);
+				device.close();
+
+				auto expected = json ? saveToString<cereal::JSONOutputArchive>(*p) : saveToString<cereal::PortableBinaryOutputArchive>(*p);
+				AssertThat(static_cast<size_t>(device.data().size()), Equals(expected.size()));
+				AssertThat(std::equal(expected.begin(), expected.end(), device.data().constBegin()), Equals(true));
+
+				Project loaded;
+				device.open(QIODevice::ReadOnly);
+				if (json) loadFrom<cereal::JSONInputArchive>(&device, loaded);
+				else loadFrom<cereal::PortableBinaryInputArchive>(&device, loaded);
+				assertLoaded(loaded);
+			}
+		});
+
+		it("round trips a project through a file", [&]()
+		{
+			QTemporaryFile file;
+			AssertThat(file.open(), Equals(true));
+			saveTo<cereal::PortableBinaryOutputArchive>(&file, *p);
+			AssertThat(file.flush(), Equals(true));
+			AssertThat(file.error(), Equals(QFileDevice::NoError));
+
+			Project loaded;
+			file.seek(0);
+			loadFrom<cereal::PortableBinaryInputArchive>(&file, loaded);
+			assertLoaded(loaded);
+		});
+
+		it("reports writes the device does not take", [&]()
+		{
+			QBuffer device;
+			device.open(QIODevice::ReadOnly);
+
+			// Small writes stay in the buffer until it is synced
+			DeviceStreamBuf buffer(&device);
+			std::ostream out(&buffer);
+			out << "pixelsynth";
+			AssertThat(out.good(), Equals(true));
+			AssertThat(buffer.pubsync(), Equals(-1));
+
+			// Larger ones fail the stream as soon as a chunk is written
+			out << std::string(256 * 1024, 'x');
+			AssertThat(out.good(), Equals(false));
+		});
+
+		it("saves and loads without holding a copy of the file in memory", [&]()
+		{
+			QTemporaryFile file;
+			AssertThat(file.open(), Equals(true));
+
+			auto streamedSavePeak = measurePeakMemory([&]() { saveTo<cereal::PortableBinaryOutputArchive>(&file, *p); });
+
+			std::string contents;
+			auto bufferedSavePeak = measurePeakMemory([&]() { contents = saveToString<cereal::PortableBinaryOutputArchive>(*p); });
+
+			AssertThat(file.flush(), Equals(true));
+			AssertThat(static_cast<size_t>(file.size()), Equals(contents.size()));
+
+			// Load once up front, so neither of the loads below is charged for growing the pools
+			{
+				std::stringstream in(contents, std::ios::in | std::ios::binary);
+				Project loaded;
+				cereal::PortableBinaryInputArchive archive(in);
+				archive(loaded);
+			}
+
+			// Like Application::load, which reads straight from the mapped file
+			auto mappedPeak = measurePeakMemory([&]()
+			{
+				auto data = file.map(0, file.size());
+				AssertThat(data == nullptr, Equals(false));
+
+				MemoryStreamBuf buffer(reinterpret_cast<const char*>(data), static_cast<size_t>(file.size()));
+				std::istream in(&buffer);
+				Project loaded;
+				cereal::PortableBinaryInputArchive archive(in);
+				archive(loaded);
+				file.unmap(data);
+			});
+
+			auto bufferedPeak = measurePeakMemory([&]()
+			{
+				std::stringstream in(contents, std::ios::in | std::ios::binary);
+				Project loaded;
+				cereal::PortableBinaryInputArchive archive(in);
+				archive(loaded);
+			});
+
+			// Going through a string stream costs at least one extra copy of the file
+			AssertThat(streamedSavePeak + contents.size(), IsLessThan(bufferedSavePeak));
+			AssertThat(mappedPeak + contents.size() / 2, IsLessThan(bufferedPeak));
+		});
+	});
+});
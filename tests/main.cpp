@@ -1,6 +1,7 @@
 #include "static.h"
 
 #include <core/factory.h>
+#include <QtWidgets/QApplication>
 
 using namespace Core;
 #include "testnode.h"
@@ -11,6 +12,10 @@ int main(int argc, char* argv[])
 	//spdlog::set_level(spdlog::level::info);
 	DefineNode(TestNode);
 
+	// The editor specs drive widgets, which don't need a display to run on
+	if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) qputenv("QT_QPA_PLATFORM", "offscreen");
+	QApplication app(argc, argv);
+
 	// Run the tests.
 	return bandit::run(argc, argv);
 }
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include "memory_tracker.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<size_t> current_ { 0 };
+static std::atomic<size_t> peak_ { 0 };
+
+// Every allocation is prefixed with its size, so it can be subtracted again when it is freed
+static const size_t headerSize = alignof(std::max_align_t) > sizeof(size_t) ? alignof(std::max_align_t) : sizeof(size_t);
+
+static void* allocate(size_t size) noexcept
+{
+	auto block = static_cast<char*>(std::malloc(size + headerSize));
+	if (!block) return nullptr;
+
+	*reinterpret_cast<size_t*>(block) = size;
+
+	auto now = current_ += size;
+	auto peak = peak_.load();
+	while (now > peak && !peak_.compare_exchange_weak(peak, now)) {}
+
+	return block + headerSize;
+}
+
+static void deallocate(void* ptr) noexcept
+{
+	if (!ptr) return;
+
+	auto block = static_cast<char*>(ptr) - headerSize;
+	current_ -= *reinterpret_cast<size_t*>(block);
+	std::free(block);
+}
+
+size_t MemoryTracker::current() noexcept
+{
+	return current_;
+}
+
+size_t MemoryTracker::peak() noexcept
+{
+	return peak_;
+}
+
+void MemoryTracker::resetPeak() noexcept
+{
+	peak_ = current_.load();
+}
+
+void* operator new(size_t size)
+{
+	auto ptr = allocate(size);
+	if (!ptr) throw std::bad_alloc();
+	return ptr;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return allocate(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	deallocate(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	deallocate(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+	deallocate(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+	deallocate(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+	deallocate(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+	deallocate(ptr);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+
+// Keeps track of the bytes allocated through the global operator new, so tests can assert on peak memory usage
+struct MemoryTracker
+{
+	static size_t current() noexcept;
+	static size_t peak() noexcept;
+
+	// Starts measuring a new peak from the current usage
+	static void resetPeak() noexcept;
+};
+
+// Returns the highest number of bytes allocated on top of the current usage while running fn
+template <typename Fn>
+size_t measurePeakMemory(Fn&& fn)
+{
+	auto base = MemoryTracker::current();
+	MemoryTracker::resetPeak();
+	fn();
+	return MemoryTracker::peak() - base;
+}
@@ -3,10 +3,16 @@
 #include <bandit/bandit.h>
 #include <tree/tree_util.h>
 
+#include <core/evaluation_cache.h>
 #include <core/factory.h>
+#include <core/graph_scheduler.h>
 #include <core/metadata.h>
 #include <core/node.h>
 #include <core/project.h>
 #include <core/connection.h>
 #include <core/mutation_info.h>
+#include <core/cubic_kernel.h>
+#include <core/sampler.h>
+#include <core/scene_evaluator.h>
+#include <core/thread_pool.h>
 #include <core/utils.h>
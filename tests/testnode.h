@@ -73,3 +73,21 @@ struct TestNode
 		AssertThat(prop(*n, "string")->get<std::string>(100), Equals("b"));
 	}
 };
+
+// Adds the given number of nodes to the root, grouped into folders of 100 nodes each
+inline void addScene(Document::Builder& b, size_t nodeCount, std::vector<NodePtr>& nodes)
+{
+	NodePtr group;
+	for (size_t i = 0; i < nodeCount; i++)
+	{
+		if (i % 100 == 0)
+		{
+			group = makeNode(hash("TestNode"), "group");
+			b.append({ group });
+		}
+
+		auto node = makeNode(hash("TestNode"), "node");
+		b.append(group, { node });
+		nodes.push_back(node);
+	}
+}